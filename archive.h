@@ -0,0 +1,648 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QHash>
+#include <QSharedPointer>
+#include <QImageReader>
+#include <QDebug>
+#include <algorithm>
+
+
+/**
+ * Raw deflate (RFC 1951) decoder for ZIP entries.
+ *
+ * Based on the canonical Huffman decoding of zlib's `puff.c`,
+ * with a lookup table for the codes up to `fastBits` length.
+ *
+ * The input is streamed: it's read from the device in `chunkSize` chunks, only the output is kept whole
+ * (the image decoder requires the whole file anyway).
+ */
+class Inflate {
+public:
+    /**
+     * Inflates `compressedSize` bytes of `device`.
+     * Returns an empty array on a malformed stream, or if the output exceeds `expectedSize`.
+     */
+    static QByteArray decode(QIODevice *device, qint64 compressedSize, qint64 expectedSize) {
+        Inflate inflate(device, compressedSize);
+        inflate.outLimit = expectedSize;
+        // The declared size is not trusted for the reservation, the output grows on demand beyond the usual ratio
+        inflate.out.reserve(qMin(expectedSize, compressedSize * reserveRatio));
+        if (!inflate.run()) {
+            return QByteArray();
+        }
+        return inflate.out;
+    }
+
+private:
+    static const int maxBits  = 15;
+    static const int fastBits = 9;
+    static const int chunkSize = 64 * 1024;
+    static const int reserveRatio = 4;
+
+    struct Huffman {
+        short   count[maxBits + 1];  // the number of the codes of each length
+        short   symbol[288];         // the symbols ordered by the code
+        quint16 fast[1 << fastBits]; // `symbol << 4 | length` by the reversed code, 0 — not in the table
+    };
+
+    QIODevice *device;
+    qint64  inRemaining; // is not read from the device yet
+    QByteArray chunk;
+    const uchar *in = nullptr;
+    qint64  inLength = 0; // of the current chunk
+    qint64  inPos = 0;
+    quint32 bitBuf = 0;
+    int     bitCount = 0;
+    bool    error = false;
+    QByteArray out;
+    qint64  outLimit = 0;
+
+    Inflate(QIODevice *device, qint64 compressedSize) : device(device), inRemaining(compressedSize) {
+        chunk.resize(qMin<qint64>(chunkSize, compressedSize));
+    }
+
+    // Reads the next chunk of the input, `false` at the end
+    bool refill() {
+        if (inRemaining <= 0) {
+            return false;
+        }
+        const qint64 read = device->read(chunk.data(), qMin<qint64>(chunk.size(), inRemaining));
+        if (read <= 0) {
+            inRemaining = 0;
+            return false;
+        }
+        inRemaining -= read;
+        in = reinterpret_cast<const uchar*>(chunk.constData());
+        inLength = read;
+        inPos = 0;
+        return true;
+    }
+
+    int bits(int need) {
+        quint32 value = bitBuf;
+        while (bitCount < need) {
+            if (inPos >= inLength && !refill()) {
+                error = true;
+                return 0;
+            }
+            value |= quint32(in[inPos++]) << bitCount;
+            bitCount += 8;
+        }
+        bitBuf = value >> need;
+        bitCount -= need;
+        return int(value & ((1u << need) - 1));
+    }
+
+    bool run() {
+        int last;
+        do {
+            last = bits(1);
+            int type = bits(2);
+            if (error) {
+                return false;
+            }
+            bool ok = false;
+            if (type == 0) {
+                ok = stored();
+            } else if (type == 1) {
+                ok = fixed();
+            } else if (type == 2) {
+                ok = dynamic();
+            }
+            if (!ok || error) {
+                return false;
+            }
+        } while (!last);
+        return true;
+    }
+
+    bool stored() {
+        // Drop the rest bits of the current byte, the whole bytes read ahead by `decode` stay in `bitBuf`
+        bitBuf >>= bitCount % 8;
+        bitCount -= bitCount % 8;
+        const unsigned length  = bits(16);
+        const unsigned nlength = bits(16);
+        if (error || length != (~nlength & 0xFFFF) || out.size() + length > outLimit) {
+            return false;
+        }
+        qint64 left = length;
+        for (; left > 0 && bitCount > 0; left--) {
+            out.append(char(bits(8)));
+        }
+        while (left > 0) {
+            if (inPos >= inLength && !refill()) {
+                return false;
+            }
+            const qint64 count = qMin(left, inLength - inPos);
+            out.append(reinterpret_cast<const char*>(in + inPos), count);
+            inPos += count;
+            left  -= count;
+        }
+        return true;
+    }
+
+    /**
+     * Returns 0 for a complete code, a positive value for an incomplete one, a negative value for an over-subscribed one.
+     */
+    static int construct(Huffman &h, const short *lengths, int n) {
+        for (int length = 0; length <= maxBits; length++) {
+            h.count[length] = 0;
+        }
+        for (int symbol = 0; symbol < n; symbol++) {
+            h.count[lengths[symbol]]++;
+        }
+        std::fill(std::begin(h.fast), std::end(h.fast), 0);
+        if (h.count[0] == n) {
+            return 0;
+        }
+
+        int left = 1;
+        for (int length = 1; length <= maxBits; length++) {
+            left <<= 1;
+            left -= h.count[length];
+            if (left < 0) {
+                return left;
+            }
+        }
+
+        short offsets[maxBits + 1];
+        offsets[1] = 0;
+        for (int length = 1; length < maxBits; length++) {
+            offsets[length + 1] = offsets[length] + h.count[length];
+        }
+        for (int symbol = 0; symbol < n; symbol++) {
+            if (lengths[symbol] != 0) {
+                h.symbol[offsets[lengths[symbol]]++] = symbol;
+            }
+        }
+
+        int code  = 0; // the first canonical code of the length
+        int index = 0;
+        for (int length = 1; length <= fastBits; length++) {
+            for (int i = 0; i < h.count[length]; i++) {
+                int reversed = 0;
+                for (int b = 0; b < length; b++) {
+                    reversed |= ((code + i) >> b & 1) << (length - 1 - b);
+                }
+                const quint16 entry = h.symbol[index + i] << 4 | length;
+                for (int j = reversed; j < (1 << fastBits); j += 1 << length) {
+                    h.fast[j] = entry;
+                }
+            }
+            index += h.count[length];
+            code = (code + h.count[length]) << 1;
+        }
+        return left;
+    }
+
+    int decode(const Huffman &h) {
+        while (bitCount < fastBits && (inPos < inLength || refill())) {
+            bitBuf |= quint32(in[inPos++]) << bitCount;
+            bitCount += 8;
+        }
+        if (bitCount >= fastBits) {
+            const quint16 entry = h.fast[bitBuf & ((1 << fastBits) - 1)];
+            if (entry != 0) {
+                const int length = entry & 15;
+                bitBuf >>= length;
+                bitCount -= length;
+                return entry >> 4;
+            }
+        }
+
+        // A long code (or the end of the stream) — go bit by bit
+        int code  = 0;
+        int first = 0;
+        int index = 0;
+        for (int length = 1; length <= maxBits; length++) {
+            code |= bits(1);
+            if (error) {
+                return -1;
+            }
+            const int count = h.count[length];
+            if (code - count < first) {
+                return h.symbol[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code  <<= 1;
+        }
+        return -1;
+    }
+
+    bool codes(const Huffman &lengthCode, const Huffman &distanceCode) {
+        static const short lengthBase[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const short lengthExtra[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const short distanceBase[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const short distanceExtra[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        for (;;) {
+            int symbol = decode(lengthCode);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 256) {
+                if (out.size() >= outLimit) {
+                    return false;
+                }
+                out.append(char(symbol));
+            } else if (symbol == 256) {
+                return true;
+            } else {
+                symbol -= 257;
+                if (symbol >= 29) {
+                    return false;
+                }
+                const int length = lengthBase[symbol] + bits(lengthExtra[symbol]);
+                symbol = decode(distanceCode);
+                if (symbol < 0 || symbol >= 30) {
+                    return false;
+                }
+                const qsizetype distance = distanceBase[symbol] + bits(distanceExtra[symbol]);
+                if (error || distance > out.size() || out.size() + length > outLimit) {
+                    return false;
+                }
+                // Byte by byte, the source can overlap the destination
+                const qsizetype start = out.size();
+                out.resize(start + length);
+                char *data = out.data();
+                for (qsizetype i = start; i < start + length; i++) {
+                    data[i] = data[i - distance];
+                }
+            }
+        }
+    }
+
+    bool fixed() {
+        struct Tables {
+            Huffman lengthCode;
+            Huffman distanceCode;
+            Tables() {
+                short lengths[288];
+                int symbol = 0;
+                for (; symbol < 144; symbol++) lengths[symbol] = 8;
+                for (; symbol < 256; symbol++) lengths[symbol] = 9;
+                for (; symbol < 280; symbol++) lengths[symbol] = 7;
+                for (; symbol < 288; symbol++) lengths[symbol] = 8;
+                construct(lengthCode, lengths, 288);
+                for (symbol = 0; symbol < 30; symbol++) lengths[symbol] = 5;
+                construct(distanceCode, lengths, 30);
+            }
+        };
+        static const Tables tables;
+        return codes(tables.lengthCode, tables.distanceCode);
+    }
+
+    bool dynamic() {
+        static const short order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+        short lengths[286 + 30];
+
+        const int lengthCount   = bits(5) + 257;
+        const int distanceCount = bits(5) + 1;
+        const int codeCount     = bits(4) + 4;
+        if (error || lengthCount > 286 || distanceCount > 30) {
+            return false;
+        }
+
+        int index = 0;
+        for (; index < codeCount; index++) {
+            lengths[order[index]] = bits(3);
+        }
+        for (; index < 19; index++) {
+            lengths[order[index]] = 0;
+        }
+
+        Huffman lengthCode;
+        Huffman distanceCode;
+        if (error || construct(lengthCode, lengths, 19) != 0) {
+            return false;
+        }
+
+        index = 0;
+        while (index < lengthCount + distanceCount) {
+            int symbol = decode(lengthCode);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 16) {
+                lengths[index++] = symbol;
+                continue;
+            }
+            short length = 0;
+            if (symbol == 16) {
+                if (index == 0) {
+                    return false;
+                }
+                length = lengths[index - 1];
+                symbol = 3 + bits(2);
+            } else if (symbol == 17) {
+                symbol = 3 + bits(3);
+            } else {
+                symbol = 11 + bits(7);
+            }
+            if (error || index + symbol > lengthCount + distanceCount) {
+                return false;
+            }
+            while (symbol--) {
+                lengths[index++] = length;
+            }
+        }
+        if (lengths[256] == 0) { // no end-of-block code
+            return false;
+        }
+
+        // Only a single length code can be incomplete
+        int left = construct(lengthCode, lengths, lengthCount);
+        if (left < 0 || (left > 0 && lengthCount - lengthCode.count[0] != 1)) {
+            return false;
+        }
+        left = construct(distanceCode, lengths + lengthCount, distanceCount);
+        if (left < 0 || (left > 0 && distanceCount - distanceCode.count[0] != 1)) {
+            return false;
+        }
+        return codes(lengthCode, distanceCode);
+    }
+};
+
+
+class ZipEntry {
+public:
+    QString   name;
+    QDateTime mtime;
+    qint64    size;
+    qint64    compressedSize;
+    qint64    headerOffset; // of the local file header
+    quint16   method;       // 0 — stored, 8 — deflated
+    quint32   crc32;        // of the uncompressed data
+};
+
+/**
+ * Read-only access to ZIP (CBZ) archives without the extraction.
+ *
+ * `open` reads the central directory only, the entries are read and decoded on demand.
+ * The opened archive is owned by its session (`DirectoryFileList`), it's found by its path with `find`
+ * while the session keeps it.
+ */
+class ZipArchive {
+    static inline QMutex mutex;
+    static inline QHash<QString, QWeakPointer<const ZipArchive>> archives; // the opened ones by the path
+
+    QString path;
+    QList<ZipEntry> entries;
+    QHash<QString, ZipEntry> byName;
+public:
+    static bool isArchive(const QFileInfo &fileInfo) {
+        if (!fileInfo.isFile()) {
+            return false;
+        }
+        QString suffix = fileInfo.suffix().toLower();
+        return suffix == "zip" || suffix == "cbz";
+    }
+
+    /**
+     * Reads the central directory, registers the archive for the entry loading (`find`).
+     * It's registered while the returned pointer (or a copy of it) is alive.
+     *
+     * The entries are all except directories, encrypted entries and unsupported compression methods,
+     * there are no entries if the archive is malformed.
+     */
+    static QSharedPointer<const ZipArchive> open(const QString &archivePath) {
+        QSharedPointer<ZipArchive> archive = QSharedPointer<ZipArchive>::create();
+        archive->path = archivePath;
+        archive->entries = readCentralDirectory(archivePath);
+        archive->byName.reserve(archive->entries.count());
+        for (const ZipEntry &entry : archive->entries) {
+            archive->byName.insert(entry.name, entry);
+        }
+        QMutexLocker locker(&mutex);
+        for (auto it = archives.begin(); it != archives.end();) { // drop the released ones
+            if (it.value().isNull()) {
+                it = archives.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        archives.insert(archivePath, archive);
+        return archive;
+    }
+    /**
+     * An opened archive by its path (the "directory" path of the entries).
+     * Null if it's not an opened archive, or its session is released.
+     */
+    static QSharedPointer<const ZipArchive> find(const QString &archivePath) {
+        QMutexLocker locker(&mutex);
+        return archives.value(archivePath).toStrongRef();
+    }
+
+    const QList<ZipEntry> &getEntries() const {
+        return entries;
+    }
+
+    // Returns the (decompressed and verified) data of an entry, a null array on an error.
+    QByteArray read(const QString &entryName) const {
+        auto entry = byName.constFind(entryName);
+        if (entry == byName.cend()) {
+            return QByteArray();
+        }
+        return readEntry(path, entry.value());
+    }
+
+    static quint32 crc32(const QByteArray &data) {
+        static const QList<quint32> table = []() {
+            QList<quint32> table(256);
+            for (quint32 i = 0; i < 256; i++) {
+                quint32 c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+                }
+                table[i] = c;
+            }
+            return table;
+        }();
+        quint32 crc = 0xFFFFFFFF;
+        for (char byte : data) {
+            crc = table.at((crc ^ uchar(byte)) & 0xFF) ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFF;
+    }
+
+private:
+    static quint16 u16(const QByteArray &data, qsizetype pos) {
+        const uchar *p = reinterpret_cast<const uchar*>(data.constData()) + pos;
+        return quint16(p[0] | p[1] << 8);
+    }
+    static quint32 u32(const QByteArray &data, qsizetype pos) {
+        return quint32(u16(data, pos)) | quint32(u16(data, pos + 2)) << 16;
+    }
+    static quint64 u64(const QByteArray &data, qsizetype pos) {
+        return quint64(u32(data, pos)) | quint64(u32(data, pos + 4)) << 32;
+    }
+
+    static QDateTime fromDosTime(quint16 date, quint16 time) {
+        return QDateTime(QDate(1980 + (date >> 9), (date >> 5) & 15, date & 31),
+                         QTime(time >> 11, (time >> 5) & 63, (time & 31) * 2));
+    }
+
+    static QList<ZipEntry> readCentralDirectory(const QString &archivePath) {
+        QList<ZipEntry> entries;
+        QFile file(archivePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return entries;
+        }
+
+        // The end of central directory record: 22 bytes + a comment up to 65535 bytes
+        const qint64 fileSize = file.size();
+        const qint64 tailSize = qMin<qint64>(fileSize, 22 + 0xFFFF);
+        file.seek(fileSize - tailSize);
+        const QByteArray tail = file.read(tailSize);
+        qsizetype eocd = -1;
+        for (qsizetype i = tail.size() - 22; i >= 0; i--) {
+            if (u32(tail, i) == 0x06054B50) {
+                eocd = i;
+                break;
+            }
+        }
+        if (eocd == -1) {
+            return entries;
+        }
+        quint64 count    = u16(tail, eocd + 10);
+        quint64 cdSize   = u32(tail, eocd + 12);
+        quint64 cdOffset = u32(tail, eocd + 16);
+
+        if (count == 0xFFFF || cdSize == 0xFFFFFFFF || cdOffset == 0xFFFFFFFF) { // ZIP64
+            const qsizetype locator = eocd - 20;
+            if (locator < 0 || u32(tail, locator) != 0x07064B50) {
+                return entries;
+            }
+            file.seek(u64(tail, locator + 8));
+            const QByteArray zip64 = file.read(56);
+            if (zip64.size() < 56 || u32(zip64, 0) != 0x06064B50) {
+                return entries;
+            }
+            count    = u64(zip64, 32);
+            cdSize   = u64(zip64, 40);
+            cdOffset = u64(zip64, 48);
+        }
+
+        // The values are not trusted, a corrupted archive must not make to allocate a lot
+        if (cdSize > quint64(fileSize) || cdOffset > quint64(fileSize) - cdSize) {
+            return entries;
+        }
+        file.seek(cdOffset);
+        const QByteArray cd = file.read(cdSize);
+        if (quint64(cd.size()) != cdSize) {
+            return entries;
+        }
+
+        count = qMin(count, cdSize / 46); // 46 bytes is the min size of a central directory record
+        entries.reserve(count);
+        qsizetype pos = 0;
+        for (quint64 i = 0; i < count; i++) {
+            if (pos + 46 > cd.size() || u32(cd, pos) != 0x02014B50) {
+                return QList<ZipEntry>();
+            }
+            const quint16 flags         = u16(cd, pos + 8);
+            const quint16 method        = u16(cd, pos + 10);
+            const quint16 time          = u16(cd, pos + 12);
+            const quint16 date          = u16(cd, pos + 14);
+            const quint32 crc32         = u32(cd, pos + 16);
+            quint64       compressedSize = u32(cd, pos + 20);
+            quint64       size           = u32(cd, pos + 24);
+            const int     nameLength    = u16(cd, pos + 28);
+            const int     extraLength   = u16(cd, pos + 30);
+            const int     commentLength = u16(cd, pos + 32);
+            quint64       headerOffset   = u32(cd, pos + 42);
+            if (pos + 46 + nameLength + extraLength + commentLength > cd.size()) {
+                return QList<ZipEntry>();
+            }
+
+            const QByteArray rawName = cd.mid(pos + 46, nameLength);
+            const QString name = flags & 0x800 ? QString::fromUtf8(rawName) : QString::fromLocal8Bit(rawName);
+
+            // The ZIP64 extra field has the 64-bit values only for the fields set to 0xFFFFFFFF
+            qsizetype extra = pos + 46 + nameLength;
+            const qsizetype extraEnd = extra + extraLength;
+            while (extra + 4 <= extraEnd) {
+                const quint16 id     = u16(cd, extra);
+                const quint16 length = u16(cd, extra + 2);
+                qsizetype field = extra + 4;
+                const qsizetype fieldEnd = qMin(field + length, extraEnd);
+                if (id == 0x0001) {
+                    if (size == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+                        size = u64(cd, field);
+                        field += 8;
+                    }
+                    if (compressedSize == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+                        compressedSize = u64(cd, field);
+                        field += 8;
+                    }
+                    if (headerOffset == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+                        headerOffset = u64(cd, field);
+                    }
+                }
+                extra += 4 + length;
+            }
+            pos += 46 + nameLength + extraLength + commentLength;
+
+            const bool isDir       = name.endsWith('/');
+            const bool isEncrypted = flags & 0x1;
+            if (isDir || isEncrypted || (method != 0 && method != 8)) {
+                continue;
+            }
+            entries << ZipEntry{name, fromDosTime(date, time), qint64(size), qint64(compressedSize), qint64(headerOffset), method, crc32};
+        }
+        return entries;
+    }
+
+    // An entry larger than the image allocation limit could not be decoded anyway
+    static qint64 maxEntrySize() {
+        const qint64 limit = QImageReader::allocationLimit(); // MB, 0 — no limit
+        return (limit > 0 ? limit : 1024) * 1024 * 1024;
+    }
+
+    static QByteArray readEntry(const QString &archivePath, const ZipEntry &entry) {
+        QFile file(archivePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QByteArray();
+        }
+        if (entry.size < 0 || entry.size > maxEntrySize()
+                || entry.compressedSize < 0 || entry.headerOffset < 0
+                || entry.headerOffset > file.size() || entry.compressedSize > file.size() - entry.headerOffset
+                || !file.seek(entry.headerOffset)) {
+            return QByteArray();
+        }
+        const QByteArray header = file.read(30);
+        if (header.size() < 30 || u32(header, 0) != 0x04034B50) {
+            return QByteArray();
+        }
+        // The local name and extra field lengths can differ from the central directory ones
+        file.seek(entry.headerOffset + 30 + u16(header, 26) + u16(header, 28));
+        QByteArray data;
+        if (entry.method == 0) {
+            data = file.read(entry.compressedSize);
+        } else {
+            data = Inflate::decode(&file, entry.compressedSize, entry.size);
+        }
+        // A truncated or corrupted entry is not passed to the image decoder
+        if (data.size() != entry.size || crc32(data) != entry.crc32) {
+            qDebug().noquote() << "[ZipArchive][corrupted]:" << entry.name;
+            return QByteArray();
+        }
+        return data;
+    }
+};
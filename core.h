@@ -2,38 +2,31 @@
 
 #include <QString>
 #include <QDateTime>
+#include <QFile>
 #include <QFileInfo>
 #include <QDir>
 #include <QImageReader>
 #include <QElapsedTimer>
 #include <QPixmap>
+#include <QBuffer>
 #include <QtConcurrent>
-
-class Timer {
-    inline static QMap<QString, QElapsedTimer> map;
-public:
-    static void start(QString name) {
-        QElapsedTimer timer;
-        timer.start();
-        map.insert(name, timer);
-    }
-    static int elapsed(QString name) {
-        if (!map.contains(name)) {
-            qDebug().noquote() << "[timer][" + name + "]: Not found.";
-        }
-        int time = map.take(name).elapsed();
-        qDebug().noquote() << "[timer][" + name + "]:" << time << "ms";
-        return time;
-    }
-};
+#include "timer.h"
+#include "filenameindex.h"
+#include "archive.h"
+#include "decoders.h"
+#include "duplicates.h"
+#include "surface.h"
 
 class SortOrders {
 public:
     // if `false` — an order is reversed
-    inline static bool mtime = true;
-    inline static bool btime = true;
-    inline static bool size  = true;
-    inline static QString by = "";
+    bool mtime = true;
+    bool btime = true;
+    bool size  = true;
+    QString by = "";
+    bool operator==(const SortOrders& target) const {
+        return mtime == target.mtime && btime == target.btime && size == target.size && by == target.by;
+    }
 };
 
 class FileEntry {
@@ -42,6 +35,7 @@ public:
     QDateTime mtime;
     QDateTime btime;
     qint64    size;
+    int       id = -1;  // in `FileNameIndex`
     QFileInfo fileInfo; // for tests only
     FileEntry(QFileInfo fileInfo) {
         this->name  = fileInfo.fileName();  // x1, filePath() is x3 faster, absoluteFilePath() x6 times slower
@@ -50,49 +44,139 @@ public:
         this->size  = fileInfo.size();
         this->fileInfo = fileInfo;
     }
+    FileEntry(const ZipEntry &zipEntry) {
+        this->name  = zipEntry.name;
+        this->mtime = zipEntry.mtime;
+        this->btime = zipEntry.mtime; // ZIP has no btime
+        this->size  = zipEntry.size;
+    }
     FileEntry() {}
     friend QDebug &operator<<(QDebug &stream, const FileEntry &target) {
         return stream << target.name;
     }
 };
 
+/**
+ * Decoded images of one directory (`Session`).
+ * The file name is the key, so a lookup does not require to build the path.
+ *
+ * All caches share one memory budget, the caches of the least recently used sessions are dropped first.
+ */
 class Cache {
     static inline int num = 0;
-    static inline QMap<QString, QFuture<QPixmap>> map;
+    static inline qint64 budget = 1024LL * 1024 * 1024; // bytes
+    static inline QList<Cache*> caches; // by the last use, the active one is the last
+    static inline QSize viewport; // the images are scaled for it in advance, it's used in the GUI thread only
+    static inline qreal dpr = 1;
+    QMap<QString, QFuture<DecodedImage>> map;
 public:
-    static void add(const QString &path) {
-        if (Cache::has(path)) {
-            // qDebug() << "has:" << path;
+    Cache() {
+        caches << this;
+    }
+    ~Cache() {
+        caches.removeOne(this);
+    }
+    Cache(const Cache&) = delete;
+    Cache& operator=(const Cache&) = delete;
+
+    void add(const QString &name, const QString &dirPath) {
+        if (has(name)) {
+            // qDebug() << "has:" << name;
             return;
         }
-        qDebug() << "cache:" << path;
+        qDebug() << "cache:" << dirPath + "/" + name;
         int i = num++;
-        QFuture<QPixmap> future = QtConcurrent::run([path, i]() {
+        QFuture<DecodedImage> future = QtConcurrent::run([dirPath, name, i, maxSize = ImageDecoders::maxSize, viewport = viewport, dpr = dpr]() {
             Timer::start("Cache QPixmap [" + QString::number(i) + "]");
-            QPixmap pixmap(path);
+            DecodedImage image = Cache::load(dirPath, name, maxSize);
+            if (viewport.isValid()) { // So, the display of a cached image does not scale it in the GUI thread
+                image.surface = Surface::scaleToFit(image.pixmap, viewport, dpr);
+            }
             Timer::elapsed("Cache QPixmap [" + QString::number(i) + "]");
-            return pixmap;
+            return image;
         });
-        map.insert(path, future);
+        map.insert(name, future);
+    }
+    // The size of the image area, the surfaces of the already cached images are not updated.
+    static void setViewport(QSize size, qreal devicePixelRatio) {
+        viewport = size;
+        dpr = devicePixelRatio;
+    }
+    /**
+     * Loads a file, or an entry of an opened archive (`ZipArchive`), with a decoder chosen by `ImageDecoders`.
+     * The image is downscaled to fit `maxSize` (if it's valid).
+     */
+    static DecodedImage load(const QString &dirPath, const QString &name, QSize maxSize) {
+        if (QSharedPointer<const ZipArchive> archive = ZipArchive::find(dirPath)) {
+            QByteArray data = archive->read(name);
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::ReadOnly);
+            return ImageDecoders::decode(&buffer, QFileInfo(name).suffix().toLower().toLatin1(), maxSize);
+        }
+        return ImageDecoders::decode(dirPath + "/" + name, maxSize);
+    }
+    DecodedImage get(const QString &name) {
+        return map.value(name).result();
+    }
+    QFuture<DecodedImage> getFuture(const QString &name) {
+        return map.value(name);
+    }
+    bool has(const QString &name) {
+        return map.contains(name);
     }
-    static QPixmap get(const QString &path) {
-        return map.value(path).result();
+    void set(const QString &name, const DecodedImage &image) {
+        map.insert(name, QtFuture::makeReadyValueFuture(image));
+        fitBudget();
     }
-    static bool has(const QString &path) {
-        return map.contains(path);
+    // It's called on each navigation, it does not allocate, if all `names` are already cached.
+    void cacheOnly(const QList<QString> &names, const QString &dirPath) {
+        for (auto it = map.begin(); it != map.end();) {
+            if (names.contains(it.key())) {
+                ++it;
+            } else {
+                it = map.erase(it);
+            }
+        }
+        for (const QString &name : names) {
+            add(name, dirPath);
+        }
+        fitBudget();
     }
-    static void set(const QString &path, const QPixmap &pixmap) {
-        map.insert(path, QtFuture::makeReadyValueFuture(pixmap));
+
+    // Marks the cache as the most recently used one.
+    void activate() {
+        caches.removeOne(this);
+        caches << this;
+        fitBudget();
     }
-    static void cacheOnly(const QList<QString> &paths) {
-        QList<QString> keys = map.keys();
-        for (QString &path : keys) {
-            if (!paths.contains(path)) {
-                map.remove(path);
+
+    // The size of the decoded images (the ones that are still decoding are not counted)
+    qint64 bytes() const {
+        qint64 result = 0;
+        for (const QFuture<DecodedImage> &future : map) {
+            if (future.isFinished() && future.resultCount() > 0) {
+                const DecodedImage image = future.result();
+                result += qint64(image.pixmap.width()) * image.pixmap.height() * image.pixmap.depth() / 8;
+                if (image.surface.cacheKey() != image.pixmap.cacheKey()) {
+                    result += qint64(image.surface.width()) * image.surface.height() * image.surface.depth() / 8;
+                }
             }
         }
-        for (const QString &path : paths) {
-            add(path);
+        return result;
+    }
+
+    static void fitBudget() {
+        qint64 total = 0;
+        for (const Cache *cache : caches) {
+            total += cache->bytes();
+        }
+        for (Cache *cache : caches) {
+            if (total <= budget || cache == caches.last()) {
+                break;
+            }
+            qDebug() << "[Cache] drop:" << cache->map.count() << "images";
+            total -= cache->bytes();
+            cache->map.clear();
         }
     }
 };
@@ -122,29 +206,44 @@ public:
 
 class DirectoryFileList {
 public:
-    FileEntry getSelectedFileEntry() {
+    const FileEntry &getSelectedFileEntry() {
         return fileEntryList.at(selectedFileEntryIndex);
     };
     QString getSelectedFileEntryPath() {
         return getPath(getSelectedFileEntry());
     };
-    QString getDirPath() {
+    const QString &getDirPath() {
         return dirPath;
     };
+    QString getPath(const FileEntry &entry) {
+        return dirPath + "/" + entry.name;
+    };
     int getSelectedFileEntryIndex() {
-        return selectedFileEntryIndex + 1;
+        return viewIndex() + 1;
     };
     int getCount() {
         return fileEntryList.count();
     };
+    // The count of the entries passed the filter
+    int getViewCount() {
+        return filtered ? view.count() : fileEntryList.count();
+    }
+    bool isFiltered() {
+        return filtered;
+    }
     DirState getState() {
         return state;
     }
     bool isEmpty() {
         return getCount() == 0;
     }
+    // The "directory" is a ZIP (CBZ) archive
+    bool isArchive() {
+        return archive;
+    }
 
     QList<QString> supportedExts = getSupportedExts();
+    SortOrders sortOrders;
 
     static QList<QString> getSupportedExts() {
         QList<QString> formats;
@@ -163,13 +262,18 @@ public:
         return formats;
     }
 
-    QList<QString> pathsRange(int left, int right) {
-        int from = selectedFileEntryIndex - left;
+    /**
+     * Fills `result` with the names of the selected entry and its neighbours.
+     * `result` is cleared, but keeps its capacity, so pass the same list to not allocate on each call.
+     */
+    void namesRange(int left, int right, QList<QString> &result) {
+        const int current = viewIndex();
+        int from = current - left;
         if (from < 0) {
             from = 0;
         }
-        int to = selectedFileEntryIndex + right;
-        const int count = getCount();
+        int to = current + right;
+        const int count = getViewCount();
         if (to >= count) {
             if (count > 0) {
                 to = count - 1;
@@ -178,12 +282,117 @@ public:
             }
         }
         // qDebug() << from << to;
-        QList<QString> result;
+        result.clear();
+        if (count == 0) {
+            return;
+        }
         for (int i = from; i <= to; i++) {
-             result << getPath(fileEntryList.at(i));
+             result << fileEntryList.at(positionAt(i)).name;
         }
         // qDebug() << result;
-        return result;
+    }
+
+    // The entry after the selected one (the first one, after the last one). The view must not be empty.
+    const FileEntry &getNextFileEntry() {
+        return fileEntryList.at(positionAt(nextViewIndex() % getViewCount()));
+    }
+
+    const QString &getFilterText() {
+        return filterText;
+    }
+
+    QList<QString> getNames() {
+        QList<QString> names;
+        names.reserve(fileEntryList.count());
+        for (const FileEntry &entry : fileEntryList) {
+            names << entry.name;
+        }
+        return names;
+    }
+    /**
+     * Reads a file, or an entry of an opened archive. Returns a null array on an error.
+     */
+    static QByteArray readData(const QString &dirPath, const QString &name) {
+        if (QSharedPointer<const ZipArchive> archive = ZipArchive::find(dirPath)) {
+            return archive->read(name);
+        }
+        QFile file(dirPath + "/" + name);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QByteArray();
+        }
+        return file.readAll();
+    }
+
+    // The entries that are not hashed yet, or changed since they were hashed
+    QList<FileEntry> getUnhashedEntries() {
+        QList<FileEntry> entries;
+        for (const FileEntry &entry : fileEntryList) {
+            if (!duplicates.isHashed(entry.name, entry.size, entry.mtime)) {
+                entries << entry;
+            }
+        }
+        return entries;
+    }
+    DuplicateIndex getDuplicateIndex() {
+        return duplicates;
+    }
+    // The index must be built (in a background thread) for the current `getNames`.
+    void setDuplicateIndex(const DuplicateIndex &index) {
+        duplicates = index;
+    }
+    // All files are hashed, the index is actual. It stops on the first unhashed file, it does not allocate.
+    bool isDuplicateIndexReady() {
+        if (duplicates.count() != fileEntryList.count()) {
+            return false;
+        }
+        for (const FileEntry &entry : fileEntryList) {
+            if (!duplicates.isHashed(entry.name, entry.size, entry.mtime)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    FileNameIndex getNameIndex() {
+        return nameIndex;
+    }
+    /**
+     * Sets the index synced (in a background thread) with the names of `getNames`.
+     */
+    void setNameIndex(const FileNameIndex &index) {
+        nameIndex = index;
+        for (FileEntry &entry : fileEntryList) {
+            entry.id = nameIndex.idOf(entry.name);
+        }
+        updatePositions();
+        if (filtered) { // Re-run the query, there may be new names
+            QString text = filterText;
+            filter("");
+            filter(text);
+        }
+    }
+
+    /**
+     * Limits the navigation with the entries which names contain `text`.
+     *
+     * The selected entry stays the same if it passes the filter, else the next passed one is selected.
+     * An empty `text` removes the filter.
+     */
+    void filter(const QString &text) {
+        if (text.isEmpty()) {
+            filtered = false;
+            filterText = "";
+            filterIds.clear();
+            view.clear();
+            return;
+        }
+        bool narrowing = filtered && text.contains(filterText, Qt::CaseInsensitive);
+        filterIds  = nameIndex.find(text, narrowing ? &filterIds : nullptr);
+        filterText = text;
+        filtered   = true;
+        updateView();
+
+        snapSelectionToView();
     }
 
 private:
@@ -191,10 +400,74 @@ private:
     QList<FileEntry> fileEntryList;
     int selectedFileEntryIndex = 0;
     DirState state = DS::Empty;
+    bool archive = false;
+    QSharedPointer<const ZipArchive> zip; // the opened archive, it's released with the session
 
-    QString getPath(FileEntry entry) {
-        return dirPath + "/" + entry.name;
-    };
+    DuplicateIndex duplicates;
+
+    FileNameIndex nameIndex;
+    QList<int> positionOfId; // `fileEntryList` index by `FileEntry::id`
+
+    bool filtered = false;
+    QString filterText = "";
+    QList<int> filterIds;
+    QList<int> view; // sorted `fileEntryList` indices of `filterIds`
+
+    // The selected entry does not pass the filter, select the next passed one (or the last one)
+    void snapSelectionToView() {
+        if (filtered && !view.isEmpty() && !isSelectedInView()) {
+            auto it = std::lower_bound(view.begin(), view.end(), selectedFileEntryIndex);
+            selectedFileEntryIndex = it != view.end() ? *it : view.last();
+        }
+    }
+    // An explicitly opened file is shown even if it does not pass the filter, so the filter is removed then
+    void unfilterSelected() {
+        if (filtered && !isSelectedInView()) {
+            filter("");
+        }
+    }
+    bool isSelectedInView() {
+        return !filtered || std::binary_search(view.begin(), view.end(), selectedFileEntryIndex);
+    }
+    // The view index of the entry after the selected one, the selected entry can be out of the view
+    int nextViewIndex() {
+        return isSelectedInView() ? viewIndex() + 1 : viewIndex();
+    }
+
+    // The position of the selected entry in the view (of the next one, if it's not in the view)
+    int viewIndex() {
+        if (!filtered) {
+            return selectedFileEntryIndex;
+        }
+        return std::lower_bound(view.begin(), view.end(), selectedFileEntryIndex) - view.begin();
+    }
+    int positionAt(int viewIndex) {
+        return filtered ? view.at(viewIndex) : viewIndex;
+    }
+
+    // Call it after `fileEntryList` is reordered.
+    void updatePositions() {
+        positionOfId.fill(-1, nameIndex.capacity());
+        for (int i = 0; i < fileEntryList.count(); i++) {
+            int id = fileEntryList.at(i).id;
+            if (id != -1) {
+                positionOfId[id] = i;
+            }
+        }
+        if (filtered) {
+            updateView();
+        }
+    }
+    void updateView() {
+        view.clear();
+        for (int id : filterIds) {
+            int position = positionOfId.value(id, -1);
+            if (position != -1) {
+                view << position;
+            }
+        }
+        std::sort(view.begin(), view.end());
+    }
 
     QList<QFileInfo> getFileInfoList(QString path) {
         QDir dir(path);
@@ -202,7 +475,7 @@ private:
         return dir.entryInfoList();
     }
 
-    bool isSupportedByExt(QString &fileName, QList<QString> &extensions) {
+    bool isSupportedByExt(const QString &fileName, QList<QString> &extensions) {
         for (const QString &ext : extensions) {
             if (fileName.endsWith(ext, Qt::CaseInsensitive)) {
                 return true;
@@ -222,6 +495,15 @@ private:
         return fileInfoListFiltered;
     }
 
+    void initFileEntryList(QList<ZipEntry> zipEntryList) {
+        fileEntryList = QList<FileEntry>();
+        for (const ZipEntry &zipEntry : zipEntryList) {
+            if (isSupportedByExt(zipEntry.name, supportedExts)) {
+                fileEntryList << FileEntry(zipEntry);
+            }
+        }
+    }
+
     void initFileEntryList(QList<QFileInfo> fileInfoList) {
         fileEntryList = QList<FileEntry>();
         for (QFileInfo &fileInfo : fileInfoList) {
@@ -241,6 +523,17 @@ private:
     }
 
 public:
+    /**
+     * Returns the directory path, `initImage` would use for `path`.
+     */
+    static QString dirPathOf(const QString &path) {
+        QFileInfo fileInfo(path);
+        if (fileInfo.isDir() || ZipArchive::isArchive(fileInfo)) {
+            return fileInfo.absoluteFilePath();
+        }
+        return fileInfo.absolutePath();
+    }
+
     /**
      * The first step of initialization.
      *
@@ -248,6 +541,7 @@ public:
      * The return value is `true` in this case, so, you can display the image immediately.
      *
      * If `path` leads to a directory, it returns `false`.
+     * A ZIP (CBZ) archive is handled as a directory.
      *
      * Then use `initFileList` to parse the directory.
      */
@@ -260,8 +554,9 @@ public:
         if (!fileInfo.exists()) {
             return DS::NotExists;
         }
-        bool isDir = fileInfo.isDir();
-        if (fileInfo.isDir()) {
+        bool isZip = ZipArchive::isArchive(fileInfo);
+        bool isDir = fileInfo.isDir() || isZip;
+        if (isDir) {
             inputDirPath = fileInfo.absoluteFilePath();
         } else {
             inputDirPath = fileInfo.absolutePath();
@@ -278,6 +573,7 @@ public:
                 int index = indexOfByFileName(inputFileName);
                 if (index != -1) {
                     selectedFileEntryIndex = index;
+                    unfilterSelected();
                     return state;
                 } else {
                     bool isSupported = isSupportedByExt(inputFileName, supportedExts);
@@ -289,25 +585,36 @@ public:
             }
         }
 
+        if (dirPath != inputDirPath) {
+            zip.reset();
+            nameIndex = FileNameIndex();
+            filter("");
+        }
         fileEntryList = QList<FileEntry>();
         selectedFileEntryIndex = 0;
         dirPath = inputDirPath;
+        archive = isZip;
 
         if (!isDir) {
             bool isSupported = isSupportedByExt(inputFileName, supportedExts);
             if (isSupported) {
                 fileEntryList << FileEntry(QFileInfo(path));
                 state = DS::Preview; // You can display the opened image now. But directory was not handled, use `initFileList` then.
-                return state;
             } else {
                 fileEntryList << FileEntry(QFileInfo(path)); // OK, let's try to open.
                 state = DS::Unsupported;
-                return state;
             }
         } else {
             state = DS::NotReady; // Need to perform `initFileList`.
-            return state;
         }
+
+        // The positions (and the filter view) refer to the replaced list.
+        // The filter query is kept, `initFileList` re-applies it to the rescanned list.
+        for (FileEntry &entry : fileEntryList) {
+            entry.id = nameIndex.idOf(entry.name);
+        }
+        updatePositions();
+        return state;
     }
     /**
      * The second step of initialization.
@@ -321,23 +628,36 @@ public:
             openedImage = fileEntryList.at(0);
         }
 
-        // 111 ms
-        Timer::start("entryInfoList");
-        QList<QFileInfo> fileInfoList = getFileInfoList(dirPath);
-        Timer::elapsed("entryInfoList");
+        if (archive) {
+            // Only the central directory is read, the entries are decoded on demand (`Cache::load`).
+            Timer::start("readCentralDirectory");
+            zip = ZipArchive::open(dirPath);
+            Timer::elapsed("readCentralDirectory");
 
-        // 6 ms
-        Timer::start("filterBySupportedExts");
-        QList<QFileInfo> fileInfoListFiltered = filterByExts(fileInfoList, supportedExts);
-        Timer::elapsed("filterBySupportedExts");
+            qDebug() << "[readCentralDirectory] zipEntryList.size:" << zip->getEntries().size();
 
-        qDebug() << "[filterBySupportedExts] fileInfoList.size:        " << fileInfoList.size();
-        qDebug() << "[filterBySupportedExts] fileInfoListFiltered.size:" << fileInfoListFiltered.size();
-
-        // 185 ms
-        Timer::start("initFileEntryList");
-        initFileEntryList(fileInfoListFiltered);
-        Timer::elapsed("initFileEntryList");
+            Timer::start("initFileEntryList");
+            initFileEntryList(zip->getEntries());
+            Timer::elapsed("initFileEntryList");
+        } else {
+            // 111 ms
+            Timer::start("entryInfoList");
+            QList<QFileInfo> fileInfoList = getFileInfoList(dirPath);
+            Timer::elapsed("entryInfoList");
+
+            // 6 ms
+            Timer::start("filterBySupportedExts");
+            QList<QFileInfo> fileInfoListFiltered = filterByExts(fileInfoList, supportedExts);
+            Timer::elapsed("filterBySupportedExts");
+
+            qDebug() << "[filterBySupportedExts] fileInfoList.size:        " << fileInfoList.size();
+            qDebug() << "[filterBySupportedExts] fileInfoListFiltered.size:" << fileInfoListFiltered.size();
+
+            // 185 ms
+            Timer::start("initFileEntryList");
+            initFileEntryList(fileInfoListFiltered);
+            Timer::elapsed("initFileEntryList");
+        }
 
 //        // 6 ms
 //        Timer::start("sortByMtime");
@@ -345,6 +665,7 @@ public:
 //        Timer::elapsed("sortByMtime");
 
         if (fileEntryList.length() == 0) {
+            updatePositions(); // Drop the view of the previous list
             state = DS::Empty;
             return state;
         }
@@ -357,6 +678,17 @@ public:
             }
         }
 
+        // The index of the same directory is updated incrementally, see `setNameIndex`.
+        for (FileEntry &entry : fileEntryList) {
+            entry.id = nameIndex.idOf(entry.name);
+        }
+        updatePositions();
+        if (hasPreviewImage) {
+            unfilterSelected();
+        } else {
+            snapSelectionToView();
+        }
+
         state = DS::Ready;
         return state;
     }
@@ -386,6 +718,7 @@ public:
                   }
         );
         selectedFileEntryIndex = indexOfByFileName(selected.name);
+        updatePositions();
     }
     void sortByBtime(bool asc = true) {
         if (fileEntryList.length() == 0) {
@@ -399,6 +732,7 @@ public:
                   }
         );
         selectedFileEntryIndex = indexOfByFileName(selected.name);
+        updatePositions();
     }
     void sortBySize(bool asc = true) {
         if (fileEntryList.length() == 0) {
@@ -411,45 +745,133 @@ public:
                   }
         );
         selectedFileEntryIndex = indexOfByFileName(selected.name);
+        updatePositions();
+    }
+    /**
+     * Groups the duplicates (see `DuplicateIndex`) together: a group is moved to the position of its first entry,
+     * the other entries keep the current order.
+     */
+    void sortBySimilarity() {
+        const int count = fileEntryList.length();
+        if (count == 0) {
+            return;
+        }
+        FileEntry selected = getSelectedFileEntry();
+        QHash<int, int> groupRanks;
+        QList<int> ranks(count);
+        for (int i = 0; i < count; i++) {
+            const int group = duplicates.groupOf(fileEntryList.at(i).name);
+            if (group == -1) {
+                ranks[i] = i;
+                continue;
+            }
+            auto found = groupRanks.constFind(group);
+            if (found == groupRanks.cend()) {
+                found = groupRanks.insert(group, i);
+            }
+            ranks[i] = found.value();
+        }
+        QList<int> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&ranks](int a, int b) {
+            return ranks.at(a) < ranks.at(b);
+        });
+        QList<FileEntry> sorted;
+        sorted.reserve(count);
+        for (int i : order) {
+            sorted << fileEntryList.at(i);
+        }
+        fileEntryList = sorted;
+        selectedFileEntryIndex = indexOfByFileName(selected.name);
+        updatePositions();
+    }
+
+
+    /**
+     * Applies the current sort order, or sorts by mtime if there is no one.
+     */
+    void sort() {
+        if (sortOrders.by == "btime") {
+            sortByBtime(sortOrders.btime);
+        } else if (sortOrders.by == "size") {
+            sortBySize(sortOrders.size);
+        } else if (sortOrders.by == "similar") {
+            sortByMtime(sortOrders.mtime);
+            sortBySimilarity();
+        } else {
+            sortOrders.by = "mtime";
+            sortByMtime(sortOrders.mtime);
+        }
     }
 
 
     bool isFirst() {
-        return selectedFileEntryIndex == 0;
+        return viewIndex() == 0;
     }
     bool isLast() {
-        if (fileEntryList.length() == 0) {
-            return true;
-        }
-        return selectedFileEntryIndex == fileEntryList.length() - 1;
+        return nextViewIndex() >= getViewCount();
     }
 
     bool goNext() {
         if (!isLast()) {
-            selectedFileEntryIndex++;
+            selectedFileEntryIndex = positionAt(nextViewIndex());
             return true;
         }
         return false;
     }
+    // Selects the next (wrapping around) entry of the view that has duplicates.
+    bool goNextDuplicate() {
+        const int count = getViewCount();
+        const int start = nextViewIndex();
+        const int tries = isSelectedInView() ? count - 1 : count;
+        for (int i = 0; i < tries; i++) {
+            const int position = positionAt((start + i) % count);
+            if (duplicates.hasDuplicates(fileEntryList.at(position).name)) {
+                selectedFileEntryIndex = position;
+                return true;
+            }
+        }
+        return false;
+    }
     bool goBack() {
         if (!isFirst()) {
-            selectedFileEntryIndex--;
+            selectedFileEntryIndex = positionAt(viewIndex() - 1);
             return true;
         }
         return false;
     }
     bool goFirst() {
-        if (!isFirst()) {
-            selectedFileEntryIndex = 0;
+        if (getViewCount() > 0 && selectedFileEntryIndex != positionAt(0)) {
+            selectedFileEntryIndex = positionAt(0);
             return true;
         }
         return false;
     }
     bool goLast() {
-        if (!isLast()) {
-            selectedFileEntryIndex = fileEntryList.length() - 1;
+        if (getViewCount() > 0 && selectedFileEntryIndex != positionAt(getViewCount() - 1)) {
+            selectedFileEntryIndex = positionAt(getViewCount() - 1);
             return true;
         }
         return false;
     }
 };
+
+/**
+ * An opened directory with its own state: the file list (with the selection, the sort order, the filter)
+ * and the decoded images.
+ * So, switching back to a directory does not require the rescan and the decoding.
+ */
+class Session {
+public:
+    DirectoryFileList fileList;
+    Cache cache;
+    bool hashing = false; // the duplicate search is running
+    QFuture<QPair<QString, ImageHashes>> hashingTasks; // of the duplicate search, per file
+
+    // Stops the duplicate search, the files that are being hashed are finished.
+    void cancelHashing() {
+        hashingTasks.cancel();
+        hashingTasks.waitForFinished();
+        hashing = false;
+    }
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QIODevice>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPixmap>
+#include <QAtomicInt>
+#include "timer.h"
+
+
+class DecodedImage {
+public:
+    QPixmap pixmap;
+    QSize   sourceSize; // the size of the image in the file, `pixmap` can be downscaled
+    QPixmap surface;    // `pixmap` scaled for the viewport, if it's prepared in advance (see `Cache::setViewport`)
+};
+
+/**
+ * A decoder backend. `ImageDecoders` chooses it by the file signature.
+ */
+class ImageDecoder {
+public:
+    virtual ~ImageDecoder() {}
+    virtual QString name() const = 0;
+    virtual bool canDecode(const QByteArray &signature) const = 0;
+
+    /**
+     * Decodes the image downscaled to fit `maxSize` (if it's valid). `format` is a hint (the file extension).
+     */
+    DecodedImage decode(QIODevice *device, const QByteArray &format, QSize maxSize) const {
+        static QAtomicInt num = 0;
+        QString timerName = "decode [" + name() + "][" + QString::number(num++) + "]";
+        Timer::start(timerName);
+        DecodedImage image = read(device, format, maxSize);
+        Timer::elapsed(timerName);
+        return image;
+    }
+
+protected:
+    virtual DecodedImage read(QIODevice *device, const QByteArray &format, QSize maxSize) const = 0;
+
+    static QSize fit(QSize size, QSize maxSize) {
+        if (maxSize.isValid() && (size.width() > maxSize.width() || size.height() > maxSize.height())) {
+            size.scale(maxSize, Qt::KeepAspectRatio);
+        }
+        return size;
+    }
+
+    static DecodedImage read(QImageReader &reader, QSize maxSize) {
+        const QSize size = reader.size();
+        const QSize scaled = fit(size, maxSize);
+        if (size.isValid() && scaled != size) {
+            reader.setScaledSize(scaled);
+        }
+        return DecodedImage{QPixmap::fromImage(reader.read()), size, QPixmap()};
+    }
+};
+
+/**
+ * Uses the libjpeg options of Qt's jpeg plugin:
+ * a scaled size is decoded with the downscaling in the DCT domain (`scale_denom`, 1/2, 1/4, 1/8),
+ * a quality below 50 switches to the fast integer IDCT and the fast (not "fancy") upsampling.
+ */
+class JpegDecoder : public ImageDecoder {
+public:
+    bool fastUpsampling = true; // for the downscaled images only
+
+    QString name() const override {
+        return "jpeg";
+    }
+    bool canDecode(const QByteArray &signature) const override {
+        return signature.startsWith("\xFF\xD8\xFF");
+    }
+
+protected:
+    DecodedImage read(QIODevice *device, const QByteArray &format, QSize maxSize) const override {
+        Q_UNUSED(format);
+        QImageReader reader(device, "jpeg");
+        const QSize size = reader.size();
+        if (fastUpsampling && fit(size, maxSize) != size) {
+            reader.setQuality(49);
+        }
+        return ImageDecoder::read(reader, maxSize);
+    }
+};
+
+class GenericDecoder : public ImageDecoder {
+public:
+    QString name() const override {
+        return "generic";
+    }
+    bool canDecode(const QByteArray &signature) const override {
+        Q_UNUSED(signature);
+        return true;
+    }
+
+protected:
+    DecodedImage read(QIODevice *device, const QByteArray &format, QSize maxSize) const override {
+        QImageReader reader(device, format);
+        return ImageDecoder::read(reader, maxSize);
+    }
+};
+
+/**
+ * The registry of the decoders, the first one that can decode the file signature is used.
+ * `GenericDecoder` (`QImageReader` with the format detection) is the fallback,
+ * other formats (WebP, PNG, ...) are downscaled by it in the decoding thread too.
+ */
+class ImageDecoders {
+public:
+    static inline JpegDecoder    jpeg;
+    static inline GenericDecoder generic;
+private:
+    static inline QList<const ImageDecoder*> decoders {&jpeg};
+public:
+
+    // The images are decoded downscaled to fit it (the largest screen), it's used in the GUI thread only,
+    // the decoding tasks get a copy of it. It's updated, when a screen is added, removed or changed.
+    static inline QSize maxSize;
+
+    // Not thread-safe, add a decoder at the startup, before any decoding.
+    static void add(const ImageDecoder *decoder) {
+        decoders.prepend(decoder);
+    }
+
+    static DecodedImage decode(QIODevice *device, const QByteArray &format, QSize maxSize) {
+        const QByteArray signature = device->peek(16);
+        for (const ImageDecoder *decoder : decoders) {
+            if (decoder->canDecode(signature)) {
+                return decoder->decode(device, format, maxSize);
+            }
+        }
+        return generic.decode(device, format, maxSize);
+    }
+    static DecodedImage decode(const QString &path, QSize maxSize) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return DecodedImage();
+        }
+        return decode(&file, QFileInfo(path).suffix().toLower().toLatin1(), maxSize);
+    }
+};
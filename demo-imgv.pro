@@ -1,5 +1,6 @@
 QT     += core gui widgets
 QT     += concurrent
+QT     += network
 CONFIG += c++17
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
@@ -14,12 +15,24 @@ QT_MIN_VERSION = 6.6.0
 }
 
 SOURCES += \
+    imagecanvas.cpp \
     win.cpp \
     main.cpp \
+    singleinstance.cpp \
+    slideshow.cpp \
     mainwindow.cpp
 
 HEADERS += \
+    archive.h \
     core.h \
+    decoders.h \
+    duplicates.h \
+    filenameindex.h \
+    imagecanvas.h \
+    surface.h \
+    singleinstance.h \
+    slideshow.h \
+    timer.h \
     win.h \
     mainwindow.h
 
@@ -30,3 +43,9 @@ FORMS += \
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
+
+# `make check` builds and runs the tests of `tests/tests.pro`
+mkpath($$OUT_PWD/tests)
+tests.target   = check
+tests.commands = cd tests && $$QMAKE_QMAKE $$shell_quote($$PWD/tests/tests.pro) && $(MAKE) check
+QMAKE_EXTRA_TARGETS += tests
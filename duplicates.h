@@ -0,0 +1,334 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QBuffer>
+#include <QImageReader>
+#include <QImage>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <numeric>
+#include <algorithm>
+
+
+/**
+ * XXH64, a fast non-cryptographic hash, for the file content comparison.
+ */
+class XXHash64 {
+public:
+    static quint64 hash(const char *data, qsizetype length, quint64 seed = 0) {
+        const uchar *p   = reinterpret_cast<const uchar*>(data);
+        const uchar *end = p + length;
+        quint64 h;
+
+        if (length >= 32) {
+            quint64 v1 = seed + P1 + P2;
+            quint64 v2 = seed + P2;
+            quint64 v3 = seed;
+            quint64 v4 = seed - P1;
+            const uchar *limit = end - 32;
+            do {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = merge(h, v1);
+            h = merge(h, v2);
+            h = merge(h, v3);
+            h = merge(h, v4);
+        } else {
+            h = seed + P5;
+        }
+        h += quint64(length);
+
+        while (p + 8 <= end) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * P1 + P4;
+            p += 8;
+        }
+        if (p + 4 <= end) {
+            h ^= quint64(read32(p)) * P1;
+            h = rotl(h, 23) * P2 + P3;
+            p += 4;
+        }
+        while (p < end) {
+            h ^= quint64(*p) * P5;
+            h = rotl(h, 11) * P1;
+            p++;
+        }
+
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static const quint64 P1 = 11400714785074694791ULL;
+    static const quint64 P2 = 14029467366897019727ULL;
+    static const quint64 P3 =  1609587929392839161ULL;
+    static const quint64 P4 =  9650029242287828579ULL;
+    static const quint64 P5 =  2870177450012600261ULL;
+
+    static quint64 rotl(quint64 x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+    static quint64 read64(const uchar *p) {
+        quint64 result = 0;
+        for (int i = 7; i >= 0; i--) {
+            result = result << 8 | p[i];
+        }
+        return result;
+    }
+    static quint32 read32(const uchar *p) {
+        return quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+    }
+    static quint64 round(quint64 acc, quint64 input) {
+        acc += input * P2;
+        acc = rotl(acc, 31);
+        return acc * P1;
+    }
+    static quint64 merge(quint64 acc, quint64 value) {
+        acc ^= round(0, value);
+        return acc * P1 + P4;
+    }
+};
+
+/**
+ * BK-tree over 64-bit hashes with the Hamming distance, for the radius search of the similar perceptual hashes.
+ */
+class BKTree {
+    struct Node {
+        quint64 hash;
+        int id;
+        QList<QPair<int, int>> children; // (distance, node index)
+    };
+    QList<Node> nodes;
+public:
+    static int distance(quint64 a, quint64 b) {
+        return qPopulationCount(a ^ b);
+    }
+
+    void add(quint64 hash, int id) {
+        if (nodes.isEmpty()) {
+            nodes << Node{hash, id, {}};
+            return;
+        }
+        int current = 0;
+        for (;;) {
+            const int d = distance(nodes.at(current).hash, hash);
+            int next = -1;
+            for (const QPair<int, int> &child : nodes.at(current).children) {
+                if (child.first == d) {
+                    next = child.second;
+                    break;
+                }
+            }
+            if (next == -1) {
+                const int index = nodes.count();
+                nodes[current].children << qMakePair(d, index);
+                nodes << Node{hash, id, {}};
+                return;
+            }
+            current = next;
+        }
+    }
+
+    QList<int> find(quint64 hash, int radius) const {
+        QList<int> result;
+        if (nodes.isEmpty()) {
+            return result;
+        }
+        QList<int> stack {0};
+        while (!stack.isEmpty()) {
+            const Node &node = nodes.at(stack.takeLast());
+            const int d = distance(node.hash, hash);
+            if (d <= radius) {
+                result << node.id;
+            }
+            for (const QPair<int, int> &child : node.children) {
+                if (qAbs(child.first - d) <= radius) {
+                    stack << child.second;
+                }
+            }
+        }
+        return result;
+    }
+};
+
+class ImageHashes {
+public:
+    qint64    size = -1;     // of the file, when it was hashed
+    QDateTime mtime;         // of the file, when it was hashed
+    bool      ok = false;    // the file was read
+    quint64   content = 0;   // XXH64 of the file content
+    bool      hasPerceptual = false;
+    quint64   perceptual = 0; // dHash
+};
+
+/**
+ * Exact (the same content) and near (similar perceptual hashes) duplicates of a directory.
+ *
+ * The hashes are kept by the file name, so only the new and changed files need to be hashed on the next search.
+ */
+class DuplicateIndex {
+public:
+    static const int similarity = 6; // the max Hamming distance of the perceptual hashes of the similar images
+    static const int minBits = 8;    // a perceptual hash with fewer set (or unset) bits is of a flat image
+
+    // A flat (or a smooth gradient) image has dHash of almost all 0 (or 1) bits, such images are not similar.
+    static bool isDegenerate(quint64 perceptual) {
+        const int bits = qPopulationCount(perceptual);
+        return bits < minBits || bits > 64 - minBits;
+    }
+
+    /**
+     * Hashes the file content, and computes the perceptual hash (dHash) from a 9x8 grayscale decode.
+     * JPEG is decoded downscaled (1/8) in the DCT domain, so it's cheap.
+     */
+    static ImageHashes hash(const QByteArray &data, const QByteArray &format) {
+        ImageHashes result;
+        result.ok = !data.isNull();
+        result.content = XXHash64::hash(data.constData(), data.size());
+
+        QByteArray copy = data; // `QBuffer` requires a non-const array, it's shared, not copied
+        QBuffer buffer(&copy);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer, format);
+        reader.setScaledSize(QSize(9, 8));
+        QImage image = reader.read();
+        if (image.isNull()) {
+            return result;
+        }
+        if (image.size() != QSize(9, 8)) {
+            image = image.scaled(9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+        image = image.convertToFormat(QImage::Format_Grayscale8);
+        for (int y = 0; y < 8; y++) {
+            const uchar *line = image.constScanLine(y);
+            for (int x = 0; x < 8; x++) {
+                result.perceptual = result.perceptual << 1 | (line[x] < line[x + 1] ? 1 : 0);
+            }
+        }
+        result.hasPerceptual = true;
+        return result;
+    }
+
+    int count() const {
+        return hashes.count();
+    }
+    // The files with the same size and mtime are not hashed again.
+    bool isHashed(const QString &name, qint64 size, const QDateTime &mtime) const {
+        auto found = hashes.constFind(name);
+        return found != hashes.cend() && found->size == size && found->mtime == mtime;
+    }
+    void insert(const QString &name, const ImageHashes &imageHashes) {
+        hashes.insert(name, imageHashes);
+    }
+    // Removes the hashes of the files that are not in `names` anymore.
+    void retain(const QList<QString> &names) {
+        QSet<QString> current(names.begin(), names.end());
+        for (auto it = hashes.begin(); it != hashes.end();) {
+            if (current.contains(it.key())) {
+                ++it;
+            } else {
+                it = hashes.erase(it);
+            }
+        }
+    }
+
+    /**
+     * Groups the duplicates: the same content (and size), or a perceptual hash within `similarity` distance.
+     *
+     * The similarity is not transitive: a group is the files similar to its first file (by name),
+     * so a chain of slightly different images is not merged into one group.
+     * The files of the same content are one file here, the degenerate perceptual hashes are not compared.
+     */
+    void build() {
+        groups.clear();
+        groupCount = 0;
+
+        QList<QString> names = hashes.keys();
+        std::sort(names.begin(), names.end()); // So, the groups do not depend on the hash table order
+        const int n = names.count();
+
+        QList<int> original(n); // the first file of the same content
+        std::iota(original.begin(), original.end(), 0);
+        QHash<QPair<quint64, qint64>, int> byContent;
+        BKTree tree;
+        for (int i = 0; i < n; i++) {
+            const ImageHashes &h = hashes[names.at(i)];
+            if (!h.ok) {
+                continue;
+            }
+            const QPair<quint64, qint64> key(h.content, h.size);
+            auto found = byContent.constFind(key);
+            if (found != byContent.cend()) {
+                original[i] = found.value();
+                continue;
+            }
+            byContent.insert(key, i);
+            if (h.hasPerceptual && !isDegenerate(h.perceptual)) {
+                tree.add(h.perceptual, i);
+            }
+        }
+
+        QList<int> group(n, -1); // the index of the first file of the group
+        for (int i = 0; i < n; i++) {
+            if (original.at(i) != i || group.at(i) != -1) {
+                continue;
+            }
+            group[i] = i;
+            const ImageHashes &h = hashes[names.at(i)];
+            if (!h.hasPerceptual || isDegenerate(h.perceptual)) {
+                continue;
+            }
+            for (int j : tree.find(h.perceptual, similarity)) {
+                if (group.at(j) == -1) {
+                    group[j] = i;
+                }
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            group[i] = group.at(original.at(i));
+        }
+
+        QHash<int, int> sizes;
+        for (int i = 0; i < n; i++) {
+            sizes[group.at(i)]++;
+        }
+        for (int i = 0; i < n; i++) {
+            if (sizes.value(group.at(i)) > 1) {
+                groups.insert(names.at(i), group.at(i));
+            }
+        }
+        for (int size : sizes) {
+            if (size > 1) {
+                groupCount++;
+            }
+        }
+    }
+
+    bool hasDuplicates(const QString &name) const {
+        return groups.contains(name);
+    }
+    // -1 if there are no duplicates
+    int groupOf(const QString &name) const {
+        return groups.value(name, -1);
+    }
+    int getGroupCount() const {
+        return groupCount;
+    }
+
+private:
+    QHash<QString, ImageHashes> hashes;
+    QHash<QString, int> groups; // only the files that have duplicates
+    int groupCount = 0;
+};
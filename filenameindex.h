@@ -0,0 +1,151 @@
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+
+
+/**
+ * Trigram index over the file names for the incremental search.
+ *
+ * Each name gets an id, the index maps each trigram of the (case folded) name to the sorted list of ids.
+ * A query intersects the lists of its trigrams, then the candidates are verified with `QString::contains`,
+ * since having all trigrams of the query does not mean containing the query.
+ *
+ * The ids are not reused, so the appending of a new name keeps the lists sorted.
+ */
+class FileNameIndex {
+public:
+    int idOf(const QString &name) const {
+        return ids.value(name, -1);
+    }
+    int capacity() const {
+        return names.count();
+    }
+    int count() const {
+        return ids.count();
+    }
+
+    void add(const QString &name) {
+        if (ids.contains(name)) {
+            return;
+        }
+        int id = names.count();
+        names << name;
+        ids.insert(name, id);
+        for (quint64 trigram : trigrams(name)) {
+            QList<int> &list = postings[trigram];
+            if (list.isEmpty() || list.last() != id) { // a trigram can be repeated in a name
+                list << id;
+            }
+        }
+    }
+    void remove(const QString &name) {
+        int id = ids.value(name, -1);
+        if (id == -1) {
+            return;
+        }
+        ids.remove(name);
+        for (quint64 trigram : trigrams(name)) {
+            auto found = postings.find(trigram);
+            if (found == postings.end()) {
+                continue;
+            }
+            QList<int> &list = found.value();
+            auto it = std::lower_bound(list.begin(), list.end(), id);
+            if (it != list.end() && *it == id) {
+                list.erase(it);
+            }
+            if (list.isEmpty()) {
+                postings.erase(found);
+            }
+        }
+        names[id] = QString();
+    }
+    /**
+     * Makes the index to contain only `current` names: adds the new ones, removes the missing ones.
+     */
+    void sync(const QList<QString> &current) {
+        QSet<QString> currentSet(current.begin(), current.end());
+        QList<QString> removed;
+        for (auto it = ids.cbegin(); it != ids.cend(); ++it) {
+            if (!currentSet.contains(it.key())) {
+                removed << it.key();
+            }
+        }
+        for (const QString &name : removed) {
+            remove(name);
+        }
+        for (const QString &name : current) {
+            add(name);
+        }
+    }
+
+    /**
+     * Returns the sorted ids of the names that contain `text` (case insensitive).
+     *
+     * Pass the previous result as `within`, if `text` contains the previous query (the user continues typing),
+     * only those ids can match.
+     */
+    QList<int> find(const QString &text, const QList<int> *within = nullptr) const {
+        QList<int> candidates;
+        if (text.length() >= 3) {
+            QList<const QList<int>*> lists;
+            for (quint64 trigram : trigrams(text)) {
+                auto found = postings.constFind(trigram);
+                if (found == postings.cend()) {
+                    return {};
+                }
+                lists << &found.value();
+            }
+            std::sort(lists.begin(), lists.end(), [](const QList<int> *a, const QList<int> *b) {
+                return a->count() < b->count();
+            });
+            candidates = within ? intersect(*lists.at(0), *within) : *lists.at(0);
+            for (int i = 1; i < lists.count() && !candidates.isEmpty(); i++) {
+                candidates = intersect(candidates, *lists.at(i));
+            }
+        } else if (within) {
+            candidates = *within;
+        } else {
+            candidates.reserve(ids.count());
+            for (int id = 0; id < names.count(); id++) {
+                if (!names.at(id).isNull()) {
+                    candidates << id;
+                }
+            }
+        }
+
+        QList<int> result;
+        for (int id : candidates) {
+            if (names.at(id).contains(text, Qt::CaseInsensitive)) {
+                result << id;
+            }
+        }
+        return result;
+    }
+
+private:
+    QList<QString> names; // by id, a removed name is a null string
+    QHash<QString, int> ids;
+    QHash<quint64, QList<int>> postings;
+
+    static QList<quint64> trigrams(const QString &name) {
+        QString folded = name.toCaseFolded();
+        QList<quint64> result;
+        for (int i = 0; i + 2 < folded.length(); i++) {
+            result << ((quint64(folded.at(i).unicode())     << 32) |
+                       (quint64(folded.at(i + 1).unicode()) << 16) |
+                        quint64(folded.at(i + 2).unicode()));
+        }
+        return result;
+    }
+
+    static QList<int> intersect(const QList<int> &a, const QList<int> &b) {
+        QList<int> result;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+        return result;
+    }
+};
@@ -0,0 +1,106 @@
+#include "imagecanvas.h"
+#include "timer.h"
+#include "surface.h"
+#include <QPainter>
+#include <QElapsedTimer>
+#include <QResizeEvent>
+
+
+ImageCanvas::ImageCanvas(QWidget *parent) : QWidget(parent) {
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(settleDelay);
+    connect(&settleTimer, &QTimer::timeout, this, &ImageCanvas::onResizeSettled);
+}
+
+/**
+ * `surface` is the image prepared with `Surface::scaleToFit` for the current size of the widget,
+ * it's used if the size is still the same, else the image is rescaled.
+ */
+void ImageCanvas::setImage(const QPixmap &image, const QPixmap &surface) {
+    this->image = image;
+    this->text  = noImageText;
+    if (Surface::isFitted(surface, image, size(), devicePixelRatioF())) {
+        this->surface = surface;
+    } else {
+        rescale();
+    }
+    update();
+}
+void ImageCanvas::setText(const QString &text) {
+    this->text    = text;
+    this->image   = QPixmap();
+    this->surface = QPixmap();
+    update();
+}
+
+QRect ImageCanvas::targetRect() const {
+    const qreal dpr = devicePixelRatioF();
+    QRect rect(QPoint(0, 0), Surface::fitSize(image.size(), size() * dpr) / dpr);
+    rect.moveCenter(this->rect().center());
+    return rect;
+}
+
+void ImageCanvas::rescale() {
+    surface = Surface::scaleToFit(image, size(), devicePixelRatioF());
+}
+
+void ImageCanvas::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    QElapsedTimer timer;
+    if (resizing) {
+        timer.start();
+    }
+
+    QPainter painter(this);
+    if (image.isNull()) {
+        painter.drawText(rect(), Qt::AlignCenter, text);
+    } else {
+        const QRect target = targetRect();
+        if (!resizing && surface.deviceIndependentSize().toSize() == target.size()) {
+            painter.drawPixmap(target.topLeft(), surface);
+        } else {
+            // The fast preview: stretch the stale surface, it's much cheaper than sampling the full size image.
+            painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+            painter.drawPixmap(target, surface.isNull() ? image : surface);
+        }
+    }
+    painter.end();
+
+    if (resizing) {
+        qint64 elapsed = timer.nsecsElapsed();
+        frames++;
+        frameTotal += elapsed;
+        frameMax = qMax(frameMax, elapsed);
+    }
+}
+
+void ImageCanvas::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    if (image.isNull()) {
+        emit viewportChanged();
+        return;
+    }
+    if (!resizing) {
+        resizing   = true;
+        frames     = 0;
+        frameTotal = 0;
+        frameMax   = 0;
+    }
+    settleTimer.start();
+}
+
+void ImageCanvas::onResizeSettled() {
+    resizing = false;
+
+    Timer::start("ImageCanvas::rescale");
+    rescale();
+    Timer::elapsed("ImageCanvas::rescale");
+
+    if (frames > 0) {
+        qDebug().noquote() << "[ImageCanvas][resize]:" << frames << "frames,"
+                           << "avg" << QString::number(frameTotal / frames / 1e6, 'f', 2) << "ms,"
+                           << "max" << QString::number(frameMax / 1e6, 'f', 2) << "ms";
+    }
+    update();
+    emit viewportChanged();
+}
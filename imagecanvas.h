@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QWidget>
+#include <QPixmap>
+#include <QTimer>
+
+
+/**
+ * Paints the current image scaled to fit the widget (but never upscaled).
+ * The fitting is done in the device pixels, so an image is not upscaled on a HiDPI screen too.
+ *
+ * Keeps the decoded image and a surface scaled to the current viewport size,
+ * so a repaint is just a blit of the cached surface.
+ *
+ * During the live resizing the stale surface is stretched with the nearest-neighbour filter,
+ * the smooth rescale is performed once the resizing is settled.
+ */
+class ImageCanvas : public QWidget
+{
+    Q_OBJECT
+
+public:
+    ImageCanvas(QWidget *parent = nullptr);
+
+    void setImage(const QPixmap &image, const QPixmap &surface = QPixmap());
+    void setText(const QString &text);
+
+signals:
+    // The size is changed (and the resizing is settled)
+    void viewportChanged();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    QPixmap image;   // the decoded image
+    QPixmap surface; // the image scaled to `targetRect()`
+    static inline const QString noImageText = "[No Image]";
+    QString text = noImageText; // is displayed when there is no image (or it's not decoded)
+
+    static const int settleDelay = 150; // ms
+    QTimer settleTimer;
+    bool resizing = false;
+
+    // Frame time stats (ns) of the current resizing, they are logged once it's settled
+    int    frames     = 0;
+    qint64 frameTotal = 0;
+    qint64 frameMax   = 0;
+
+    QRect targetRect() const;
+    void rescale();
+    void onResizeSettled();
+};
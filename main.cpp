@@ -1,10 +1,26 @@
 #include <QApplication>
 #include "mainwindow.h"
+#include "singleinstance.h"
 
 int main(int argc, char *argv[])
 {
     QApplication application(argc, argv);
+
+    QStringList arguments = application.arguments();
+    const bool newInstance = arguments.removeAll(SingleInstance::newInstanceOption) > 0;
+    QString path = arguments.count() > 1 ? arguments.at(1) : QString();
+
+    SingleInstance instance;
+    if (!newInstance) {
+        if (instance.forward(path)) {
+            return 0; // The running instance has opened it (or just activated).
+        }
+        instance.listen();
+    }
+
     MainWindow window;
+    QObject::connect(&instance, &SingleInstance::pathReceived, &window, &MainWindow::openPath);
+    QObject::connect(&instance, &SingleInstance::activationRequested, &window, &MainWindow::activate);
     window.show();
     return application.exec();
 }
@@ -5,14 +5,19 @@
 #include "core.h"
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "singleinstance.h"
 #include <QPixmap>
 #include <QMimeData>
 #include <QImageReader>
 #include <QWheelEvent>
+#include <QScreen>
 #include <QtConcurrent>
 
 
 MainWindow::~MainWindow() {
+    for (const QSharedPointer<Session> &session : sessions) {
+        session->cancelHashing();
+    }
     delete ui;
 }
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
@@ -22,6 +27,21 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     setAcceptDrops(true);
     QImageReader::setAllocationLimit(512);
 
+    hashingPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 2));
+
+    updateMaxDecodeSize();
+    for (QScreen *screen : QGuiApplication::screens()) {
+        watchScreen(screen);
+    }
+    connect(qApp, &QGuiApplication::screenAdded, this, [this](QScreen *screen) {
+        watchScreen(screen);
+        updateMaxDecodeSize();
+    });
+    // Queued, so the removed screen is not in the list anymore
+    connect(qApp, &QGuiApplication::screenRemoved, this, &MainWindow::updateMaxDecodeSize, Qt::QueuedConnection);
+
+    activateSession(QSharedPointer<Session>::create());
+
     connect(ui->pushButton_First, &QPushButton::clicked, this, &MainWindow::first);
     connect(ui->pushButton_Last,  &QPushButton::clicked, this, &MainWindow::last);
     connect(ui->pushButton_Next,  &QPushButton::clicked, this, &MainWindow::next);
@@ -30,6 +50,18 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     connect(ui->pushButton_SZ, &QPushButton::clicked, this, &MainWindow::sortBySize);
     connect(ui->pushButton_MT, &QPushButton::clicked, this, &MainWindow::sortByMtime);
     connect(ui->pushButton_BT, &QPushButton::clicked, this, &MainWindow::sortByBtime);
+    connect(ui->pushButton_SIM, &QPushButton::clicked, this, &MainWindow::sortBySimilarity);
+    connect(ui->pushButton_DUP, &QPushButton::clicked, this, &MainWindow::nextDuplicate);
+
+    connect(ui->lineEdit_Filter, &QLineEdit::textChanged, this, &MainWindow::filter);
+
+    connect(ui->canvas_Image, &ImageCanvas::viewportChanged, this, &MainWindow::updateViewport);
+
+    connect(ui->comboBox_Dirs, &QComboBox::activated, this, &MainWindow::switchSession);
+
+    connect(ui->pushButton_Play, &QPushButton::toggled, this, &MainWindow::toggleSlideshow);
+    connect(ui->spinBox_Interval, &QSpinBox::valueChanged, &slideshow, &Slideshow::setInterval);
+    connect(&slideshow, &Slideshow::deadlineReached, this, &MainWindow::showSlide);
 
     init();
 }
@@ -38,8 +70,10 @@ void MainWindow::init() {
     logProgramArguments();
     qDebug() << "[supportedExts]:" << DirectoryFileList::getSupportedExts();
 
-    if (qApp->arguments().count() > 1) {
-        QString argv1 = qApp->arguments().at(1);
+    QStringList arguments = qApp->arguments();
+    arguments.removeAll(SingleInstance::newInstanceOption);
+    if (arguments.count() > 1) {
+        QString argv1 = arguments.at(1);
         handleInputPath(argv1);
     } else {
         // [Note]: Comment it on the release.
@@ -48,6 +82,19 @@ void MainWindow::init() {
     }
 }
 
+// A path from another launch of the program (`SingleInstance`)
+void MainWindow::openPath(QString path) {
+    activate();
+    handleInputPath(path);
+}
+void MainWindow::activate() {
+    if (isMinimized()) {
+        showNormal();
+    }
+    raise();
+    activateWindow();
+}
+
 void MainWindow::handleInputPath(QString inputPath) {
     qDebug().noquote() << "[handleInputPath]:" << inputPath;
 
@@ -60,12 +107,29 @@ void MainWindow::handleInputPath(QString inputPath) {
     }
 #endif
 
-    DirState state = fileList.initImage(inputPath);
+    if (!QFileInfo::exists(inputPath)) {
+        qDebug() << "[state]" << DS::NotExists;
+        return;
+    }
+
+    QString dirPath = DirectoryFileList::dirPathOf(inputPath);
+    QSharedPointer<Session> target = findSession(dirPath);
+    if (!target) {
+        if (fileList->getState() == DS::Empty) { // Reuse the initial (or an empty) session
+            target = session;
+        } else {
+            target = QSharedPointer<Session>::create();
+        }
+    }
+    activateSession(target);
+
+    DirState state = fileList->initImage(inputPath);
     qDebug() << "[state]" << state;
 
     if (state == DS::NotExists) {
         return;
     }
+    updateSessionList();
 
     if (state == DS::Ready) { // Opening a new file from the same directory, for example.
         update();
@@ -73,89 +137,185 @@ void MainWindow::handleInputPath(QString inputPath) {
     }
 
     if (state == DS::Unsupported) { // Let't try to display it. // Or just remove that to ignore them.
-        ui->label_Image->setText("[Unsupported]");
+        showText("[Unsupported]");
         update();
         return;
     }
 
+    target->cancelHashing(); // The file list is read again
+
     if (state == DS::Preview) { // `true` if it's a file, not directory
         update();
     } else {
-        ui->label_Image->setText("Parsing...");
+        showText("Parsing...");
         setWindowTitle(inputPath);
     }
 
-    QtConcurrent::run([this]() {
+    QtConcurrent::run([target]() {
         Timer::start("initFileList");
-        DirState state = fileList.initFileList();
+        DirState state = target->fileList.initFileList();
         Timer::elapsed("initFileList");
 
-        sortByMtime();
+        // Keep the order of the archive entries, it's the page order usually
+        if (!target->fileList.isArchive()) {
+            Timer::start("sort");
+            target->fileList.sort();
+            Timer::elapsed("sort");
+        }
 
         return state;
-    }).then([&](DirState state) {
+    }).then(this, [this, target](DirState state) {
+        if (state == DS::Ready) {
+            buildNameIndex(target);
+        }
+        if (target != session) { // Another directory was selected meanwhile
+            updateSessionList();
+            return;
+        }
         if (state == DS::Ready) {
             update();
         } else if (state == DS::Empty) {
-            ui->label_Image->setText("[No Images]");
+            showText("[No Images]");
         }
     });
 }
 
+QSharedPointer<Session> MainWindow::findSession(const QString &dirPath) {
+    for (const QSharedPointer<Session> &session : sessions) {
+        if (session->fileList.getDirPath() == dirPath) {
+            return session;
+        }
+    }
+    return nullptr;
+}
+
+// Makes `target` the current session, its file list, cache and filter are used then.
+void MainWindow::activateSession(const QSharedPointer<Session> &target) {
+    sessions.removeOne(target);
+    sessions << target;
+    while (sessions.count() > maxSessions) {
+        sessions.takeFirst()->cancelHashing(); // Other background tasks keep their session until they're finished
+    }
+
+    session  = target;
+    fileList = &session->fileList;
+    cache    = &session->cache;
+    cache->activate();
+    currentImageName = "";
 
-void MainWindow::update() {
-    if (fileList.isEmpty()) {
+    QSignalBlocker blocker(ui->lineEdit_Filter);
+    ui->lineEdit_Filter->setText(fileList->getFilterText());
+    ui->lineEdit_Filter->setEnabled(fileList->getState() == DS::Ready);
+}
+
+// Switches to a directory from the list of the opened ones, it's instant, no parsing and decoding.
+void MainWindow::switchSession(int index) {
+    QSharedPointer<Session> target = findSession(ui->comboBox_Dirs->itemData(index).toString());
+    if (!target || target == session) {
         return;
     }
+    Timer::start("switchSession");
+    activateSession(target);
+    updateSessionList();
+    if (fileList->getState() == DS::NotReady) {
+        showText("Parsing...");
+        setWindowTitle(fileList->getDirPath());
+    } else if (fileList->isEmpty()) {
+        showText("[No Images]");
+    } else {
+        update();
+    }
+    Timer::elapsed("switchSession");
+}
 
-    QString imgPath = fileList.getSelectedFileEntryPath();
-    if (currentImagePath != imgPath) {
+void MainWindow::updateSessionList() {
+    QSignalBlocker blocker(ui->comboBox_Dirs);
+    ui->comboBox_Dirs->clear();
+    for (int i = sessions.count() - 1; i >= 0; i--) {
+        QString dirPath = sessions.at(i)->fileList.getDirPath();
+        if (!dirPath.isEmpty()) {
+            ui->comboBox_Dirs->addItem(QFileInfo(dirPath).fileName(), dirPath);
+            ui->comboBox_Dirs->setItemData(ui->comboBox_Dirs->count() - 1, dirPath, Qt::ToolTipRole);
+        }
+    }
+    ui->comboBox_Dirs->setCurrentIndex(0);
+}
 
-        Timer::start("displayImage");
-        displayImage(imgPath);
-        Timer::elapsed("displayImage");
 
-        currentImagePath = imgPath;
+void MainWindow::update() {
+    if (fileList->isEmpty()) {
+        return;
+    }
+
+    const FileEntry &entry = fileList->getSelectedFileEntry();
+    if (currentImageName != entry.name) {
+        displayImage(entry);
+        currentImageName = entry.name;
+        shownIndex = -1;
+        updateStatusBar();
     }
 
     updateTitle();
-    updateStatusBar();
     setOrderDirectionInButtons();
     updateMoveButtons();
+    updateFilterText();
 
     cacheAdjacentImages();
 }
 void MainWindow::updateTitle() {
-    if (fileList.getState() == DS::Preview) {
-        setWindowTitle("[ ... ] " + fileList.getSelectedFileEntry().name);
+    if (shownIndex == fileList->getSelectedFileEntryIndex() && shownViewCount == fileList->getViewCount()
+            && shownCount == fileList->getCount() && shownState == fileList->getState()
+            && shownFiltered == fileList->isFiltered()) {
+        return;
+    }
+    shownIndex     = fileList->getSelectedFileEntryIndex();
+    shownViewCount = fileList->getViewCount();
+    shownCount     = fileList->getCount();
+    shownState     = fileList->getState();
+    shownFiltered  = fileList->isFiltered();
+
+    if (fileList->getState() == DS::Preview) {
+        setWindowTitle("[ ... ] " + fileList->getSelectedFileEntry().name);
         return;
     }
-    QString index = QString::number(fileList.getSelectedFileEntryIndex());
-    QString total = QString::number(fileList.getCount());
+    QString index = QString::number(fileList->getSelectedFileEntryIndex());
+    QString total = QString::number(fileList->getViewCount());
+    if (fileList->isFiltered()) {
+        if (fileList->getViewCount() == 0) {
+            index = "0";
+        }
+        total += " of " + QString::number(fileList->getCount());
+    }
 
 
-    setWindowTitle("[" + index + "/" + total + "] " + fileList.getSelectedFileEntry().name);
+    setWindowTitle("[" + index + "/" + total + "] " + fileList->getSelectedFileEntry().name);
 }
 void MainWindow::updateStatusBar() {
-    FileEntry entry = fileList.getSelectedFileEntry();
+    const FileEntry &entry = fileList->getSelectedFileEntry();
     QLocale locale = this->locale();
     QString size = locale.formattedDataSize(entry.size);
     ui->statusbar->showMessage(
                 "Size: "  + size                                                                           + ",   " +
                 "mtime: " + entry.mtime.toTimeZone(QTimeZone::UTC).toString("yyyy.MM.dd hh:mm:ss.zzz") + "Z,   " +
                 "btime: " + entry.btime.toTimeZone(QTimeZone::UTC).toString("yyyy.MM.dd hh:mm:ss.zzz") + "Z,   " +
-                QString::number(image.width()) + "x" + QString::number(image.height())
+                QString::number(image.sourceSize.width()) + "x" + QString::number(image.sourceSize.height())
     );
 }
-void MainWindow::updateMoveButtons() { //todo: keep the state, update only if it was changed
-    if (fileList.isFirst()) {
+void MainWindow::updateMoveButtons() {
+    const int state = (fileList->isFirst() ? 1 : 0) | (fileList->isLast() ? 2 : 0);
+    if (state == moveButtonsState) {
+        return;
+    }
+    moveButtonsState = state;
+
+    if (fileList->isFirst()) {
         ui->pushButton_First->setStyleSheet("color: gray");
         ui->pushButton_Prev->setStyleSheet("color: gray");
     } else {
         ui->pushButton_First->setStyleSheet("color: black");
         ui->pushButton_Prev->setStyleSheet("color: black");
     }
-    if (fileList.isLast()) {
+    if (fileList->isLast()) {
         ui->pushButton_Last->setStyleSheet("color: gray");
         ui->pushButton_Next->setStyleSheet("color: gray");
     } else {
@@ -165,24 +325,224 @@ void MainWindow::updateMoveButtons() { //todo: keep the state, update only if it
 }
 
 
-void MainWindow::displayImage(QString imagePath) {
-    if (Cache::has(imagePath)) {
-        image = Cache::get(imagePath);
+// Builds (or updates, for the same directory) the file name index in a background thread.
+void MainWindow::buildNameIndex(QSharedPointer<Session> target) {
+    FileNameIndex index = target->fileList.getNameIndex();
+    QList<QString> names = target->fileList.getNames();
+    QtConcurrent::run([index, names]() mutable {
+        Timer::start("buildNameIndex");
+        index.sync(names);
+        Timer::elapsed("buildNameIndex");
+        return index;
+    }).then(this, [this, target](FileNameIndex index) {
+        target->fileList.setNameIndex(index);
+        if (target == session) {
+            ui->lineEdit_Filter->setEnabled(true);
+            update();
+        }
+    });
+}
+
+/**
+ * Hashes (in parallel) the files that are not hashed yet, builds the duplicate index in a background thread,
+ * then calls `onReady`, if the session is still the current one.
+ *
+ * Each task reads a whole file, hashes it (XXH64) and decodes a tiny 9x8 image for the perceptual hash,
+ * so the reading of some files overlaps the hashing/decoding of the others.
+ * It runs on `hashingPool`, capped below the core count, the global pool stays free for the preloading.
+ */
+void MainWindow::findDuplicates(std::function<void()> onReady) {
+    if (fileList->isDuplicateIndexReady()) {
+        onReady();
+        return;
+    }
+    if (session->hashing) {
+        return;
+    }
+    QSharedPointer<Session> target = session;
+    target->hashing = true;
+
+    QList<FileEntry> entries = target->fileList.getUnhashedEntries();
+    QList<QString> names = target->fileList.getNames();
+    DuplicateIndex index = target->fileList.getDuplicateIndex();
+    QString dirPath = target->fileList.getDirPath();
+
+    ui->statusbar->showMessage("Hashing " + QString::number(entries.count()) + " files...");
+    Timer::start("findDuplicates");
+    QFuture<QPair<QString, ImageHashes>> tasks = QtConcurrent::mapped(&hashingPool, entries, [dirPath](const FileEntry &entry) {
+        QByteArray data = DirectoryFileList::readData(dirPath, entry.name);
+        ImageHashes hashes = DuplicateIndex::hash(data, QFileInfo(entry.name).suffix().toLower().toLatin1());
+        hashes.size  = entry.size;
+        hashes.mtime = entry.mtime;
+        return qMakePair(entry.name, hashes);
+    });
+    target->hashingTasks = tasks;
+    tasks.then(&hashingPool, [index, names](QFuture<QPair<QString, ImageHashes>> future) mutable {
+        if (future.isCanceled()) { // The results are partial, they are dropped
+            return index;
+        }
+        for (const QPair<QString, ImageHashes> &result : future.results()) {
+            index.insert(result.first, result.second);
+        }
+        index.retain(names);
+        index.build();
+        return index;
+    }).then(this, [this, target, tasks, onReady](DuplicateIndex index) {
+        if (tasks.isCanceled()) { // `cancelHashing` has already reset the session's state
+            return;
+        }
+        Timer::elapsed("findDuplicates");
+        qDebug() << "[findDuplicates] groups:" << index.getGroupCount();
+        target->hashing = false;
+        target->fileList.setDuplicateIndex(index);
+        if (target == session) {
+            updateStatusBar(); // Replaces the progress message
+            onReady();
+        }
+    });
+}
+
+void MainWindow::nextDuplicate() {
+    if (fileList->isEmpty()) {
+        return;
+    }
+    findDuplicates([this]() {
+        if (fileList->goNextDuplicate()) {
+            update();
+        } else {
+            ui->statusbar->showMessage("No duplicates");
+        }
+    });
+}
+
+void MainWindow::filter(const QString &text) {
+    Timer::start("filter");
+    fileList->filter(text);
+    Timer::elapsed("filter");
+    update();
+}
+
+// A cached image is displayed with its prepared surface, without the scaling, the timing and the logging.
+void MainWindow::displayImage(const FileEntry &entry) {
+    if (cache->has(entry.name)) {
+        image = cache->get(entry.name);
     } else {
-        image = QPixmap(imagePath);
-        Cache::set(imagePath, image);
+        Timer::start("displayImage");
+        image = Cache::load(fileList->getDirPath(), entry.name, ImageDecoders::maxSize);
+        Timer::elapsed("displayImage");
+        cache->set(entry.name, image);
+    }
+
+    ui->canvas_Image->setImage(image.pixmap, preparedSurface.isNull() ? image.surface : preparedSurface);
+}
+
+// The filter is removed by the file list, if an opened file does not pass it
+void MainWindow::updateFilterText() {
+    if (ui->lineEdit_Filter->text() != fileList->getFilterText()) {
+        QSignalBlocker blocker(ui->lineEdit_Filter);
+        ui->lineEdit_Filter->setText(fileList->getFilterText());
+    }
+}
+
+// Replaces the image with a text, so the next `update` displays the image again.
+void MainWindow::showText(const QString &text) {
+    ui->canvas_Image->setText(text);
+    currentImageName = "";
+}
+
+// Decode the images no larger than the largest screen, the window can't show more.
+// The already cached images are not decoded again.
+void MainWindow::updateMaxDecodeSize() {
+    QSize maxSize;
+    for (const QScreen *screen : QGuiApplication::screens()) {
+        maxSize = maxSize.expandedTo(screen->size() * screen->devicePixelRatio());
+    }
+    if (maxSize != ImageDecoders::maxSize) {
+        qDebug() << "[maxDecodeSize]:" << maxSize;
+        ImageDecoders::maxSize = maxSize;
+    }
+}
+// A resolution or a scale change of a screen changes its size in the device pixels.
+void MainWindow::watchScreen(QScreen *screen) {
+    connect(screen, &QScreen::geometryChanged,          this, &MainWindow::updateMaxDecodeSize);
+    connect(screen, &QScreen::logicalDotsPerInchChanged, this, &MainWindow::updateMaxDecodeSize);
+}
+
+void MainWindow::updateViewport() {
+    Cache::setViewport(ui->canvas_Image->size(), ui->canvas_Image->devicePixelRatioF());
+}
+
+void MainWindow::toggleSlideshow(bool checked) {
+    if (!checked) {
+        slideshow.stop();
+        slideGeneration++;
+        return;
     }
+    if (fileList->isEmpty()) {
+        ui->pushButton_Play->setChecked(false);
+        return;
+    }
+    prepareSlide();
+    slideshow.start(ui->spinBox_Interval->value());
+}
 
-    const int maxWidth = 1024;
-    const int maxHeight = 728;
-    int width  = image.width()  < maxWidth  ? image.width()  : maxWidth;
-    int height = image.height() < maxHeight ? image.height() : maxHeight;
-    ui->label_Image->setPixmap(image.scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+// Decodes (with `Cache`) and scales the next image ahead of the deadline.
+void MainWindow::prepareSlide() {
+    slideGeneration++;
+    if (fileList->getViewCount() == 0) {
+        slide = QFuture<Slide>();
+        return;
+    }
+    QString name = fileList->getNextFileEntry().name;
+    QString dirPath = fileList->getDirPath();
+    cache->add(name, dirPath);
+    QSize viewport = ui->canvas_Image->size();
+    qreal dpr = ui->canvas_Image->devicePixelRatioF();
+    slide = cache->getFuture(name).then(QtFuture::Launch::Async, [dirPath, name, viewport, dpr](DecodedImage image) {
+        // The preloading task has scaled it already, if the viewport is the same
+        if (Surface::isFitted(image.surface, image.pixmap, viewport, dpr)) {
+            return Slide{dirPath, name, image.surface};
+        }
+        return Slide{dirPath, name, Surface::scaleToFit(image.pixmap, viewport, dpr)};
+    });
+}
+
+void MainWindow::showSlide() {
+    if (!slideshow.isActive()) {
+        return;
+    }
+    if (!slide.isValid()) { // Nothing to show
+        ui->pushButton_Play->setChecked(false);
+        return;
+    }
+    if (!slide.isFinished()) { // Not ready at the deadline, show it once it's ready (it's reported as late)
+        const int generation = slideGeneration;
+        slide.then(this, [this, generation](Slide) {
+            if (generation != slideGeneration) { // The slide was replaced (or shown), or the slideshow was restarted
+                return;
+            }
+            showSlide();
+        });
+        return;
+    }
+
+    Slide next = slide.result();
+    if (!fileList->goNext()) {
+        fileList->goFirst();
+    }
+    if (fileList->getDirPath() == next.dirPath && fileList->getSelectedFileEntry().name == next.name) { // Else the user has navigated (or switched the session) meanwhile
+        preparedSurface = next.surface;
+    }
+    update();
+    preparedSurface = QPixmap();
+
+    slideshow.frameShown();
+    prepareSlide();
 }
 
 void MainWindow::cacheAdjacentImages() {
-    QList<QString> paths = fileList.pathsRange(1, 1);
-    Cache::cacheOnly(paths);
+    fileList->namesRange(1, 1, adjacentNames);
+    cache->cacheOnly(adjacentNames, fileList->getDirPath());
 }
 
 void MainWindow::dragEnterEvent(QDragEnterEvent *event) {
@@ -211,92 +571,117 @@ void MainWindow::wheelEvent(QWheelEvent *event) {
     }
 }
 void MainWindow::next() {
-    if (fileList.goNext()) {
+    if (fileList->goNext()) {
         update();
     }
 }
 void MainWindow::prev() {
-    if (fileList.goBack()) {
+    if (fileList->goBack()) {
         update();
     }
 }
 void MainWindow::first() {
-    if (fileList.goFirst()) {
+    if (fileList->goFirst()) {
         update();
     }
 }
 void MainWindow::last() {
-    if (fileList.goLast()) {
+    if (fileList->goLast()) {
         update();
     }
 }
 
 
 void MainWindow::setOrderDirectionInButtons() {
+    if (sortButtonsShown && shownSortOrders == fileList->sortOrders) {
+        return;
+    }
+    shownSortOrders = fileList->sortOrders;
+    sortButtonsShown = true;
+
     ui->pushButton_MT->setText("MT");
     ui->pushButton_BT->setText("BT");
     ui->pushButton_SZ->setText("SZ");
+    ui->pushButton_SIM->setText("SIM");
 
-    if (SortOrders::by.length()) {
+    if (fileList->sortOrders.by.length()) {
         QString direction;
-        if (SortOrders::by == "mtime") {
-            direction = SortOrders::mtime ? "↑" : "↓";
+        if (fileList->sortOrders.by == "mtime") {
+            direction = fileList->sortOrders.mtime ? "↑" : "↓";
             ui->pushButton_MT->setText("MT" + direction);
         } else
-        if (SortOrders::by == "btime") {
-            direction = SortOrders::btime ? "↑" : "↓";
+        if (fileList->sortOrders.by == "btime") {
+            direction = fileList->sortOrders.btime ? "↑" : "↓";
             ui->pushButton_BT->setText("BT" + direction);
         } else
-        if (SortOrders::by == "size") {
-            direction = SortOrders::size ? "↑" : "↓";
+        if (fileList->sortOrders.by == "size") {
+            direction = fileList->sortOrders.size ? "↑" : "↓";
             ui->pushButton_SZ->setText("SZ" + direction);
+        } else
+        if (fileList->sortOrders.by == "similar") {
+            ui->pushButton_SIM->setText("SIM•");
         }
     }
 }
 
 // Pretty fast, no need to use QtConcurrent
 void MainWindow::sortByMtime() {
-    bool asc = SortOrders::mtime;
-    if (SortOrders::by == "mtime") {
+    bool asc = fileList->sortOrders.mtime;
+    if (fileList->sortOrders.by == "mtime") {
         asc = !asc;
     }
-    SortOrders::by = "mtime";
-    SortOrders::mtime = asc;
+    fileList->sortOrders.by = "mtime";
+    fileList->sortOrders.mtime = asc;
 
     Timer::start("sortByMtime");
-    fileList.sortByMtime(asc);
+    fileList->sortByMtime(asc);
     Timer::elapsed("sortByMtime");
 
     update();
 }
 void MainWindow::sortByBtime() {
-    bool asc = SortOrders::btime;
-    if (SortOrders::by == "btime") {
+    bool asc = fileList->sortOrders.btime;
+    if (fileList->sortOrders.by == "btime") {
         asc = !asc;
     }
-    SortOrders::by = "btime";
-    SortOrders::btime = asc;
+    fileList->sortOrders.by = "btime";
+    fileList->sortOrders.btime = asc;
 
     Timer::start("sortByBtime");
-    fileList.sortByBtime(asc);
+    fileList->sortByBtime(asc);
     Timer::elapsed("sortByBtime");
 
     update();
 }
 void MainWindow::sortBySize() {
-    bool asc = SortOrders::size;
-    if (SortOrders::by == "size") {
+    bool asc = fileList->sortOrders.size;
+    if (fileList->sortOrders.by == "size") {
         asc = !asc;
     }
-    SortOrders::by = "size";
-    SortOrders::size = asc;
+    fileList->sortOrders.by = "size";
+    fileList->sortOrders.size = asc;
 
     Timer::start("sortBySize");
-    fileList.sortBySize(asc);
+    fileList->sortBySize(asc);
     Timer::elapsed("sortBySize");
 
     update();
 }
+// Groups the duplicates within the current order, the files are hashed first, if required
+void MainWindow::sortBySimilarity() {
+    if (fileList->isEmpty()) {
+        return;
+    }
+    findDuplicates([this]() {
+        fileList->sortOrders.by = "similar";
+
+        Timer::start("sortBySimilarity");
+        fileList->sortBySimilarity();
+        Timer::elapsed("sortBySimilarity");
+
+        update();
+    });
+}
 
 
 void MainWindow::logProgramArguments() {
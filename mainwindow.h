@@ -3,7 +3,12 @@
 #include <QMainWindow>
 #include <QWheelEvent>
 #include <QDragEnterEvent>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QScreen>
+#include <functional>
 #include "core.h"
+#include "slideshow.h"
 
 
 namespace Ui {
@@ -18,15 +23,50 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    void openPath(QString path);
+    void activate();
+
 private:
     Ui::MainWindow *ui;
-    DirectoryFileList fileList;
-    QString currentImagePath;
-    QPixmap image;
+    static const int maxSessions = 8;
+    QList<QSharedPointer<Session>> sessions; // by the last use, the current one is the last
+    QSharedPointer<Session> session;
+    DirectoryFileList *fileList = nullptr; // of the current session
+    Cache *cache = nullptr;                // of the current session
+    QString currentImageName;
+    int shownIndex = -1; // the title parts, the title is formatted only if one of them is changed
+    int shownViewCount = -1;
+    int shownCount = -1;
+    DirState shownState = DS::Empty;
+    bool shownFiltered = false; // the " of N" suffix
+    QList<QString> adjacentNames; // reused by `cacheAdjacentImages`
+
+    // The button states are kept to not restyle them on each navigation
+    int moveButtonsState = -1;
+    SortOrders shownSortOrders;
+    bool sortButtonsShown = false;
+    DecodedImage image;
+    QPixmap preparedSurface; // the scaled image for `displayImage`, if it's prepared in advance
+
+    struct Slide {
+        QString dirPath; // the names collide across the sessions (e.g. the pages of CBZ archives)
+        QString name;
+        QPixmap surface;
+    };
+    Slideshow slideshow;
+
+    // The duplicate search does not use the global pool, so the preloading and the slideshow keep free threads
+    QThreadPool hashingPool;
+    QFuture<Slide> slide; // the next one
+    int slideGeneration = 0; // is changed when `slide` is replaced or the slideshow is stopped
 
     void handleInputPath(QString inputPath);
+    QSharedPointer<Session> findSession(const QString &dirPath);
+    void activateSession(const QSharedPointer<Session> &target);
+    void switchSession(int index);
+    void updateSessionList();
     void init();
-    void displayImage(QString imagePath);
+    void displayImage(const FileEntry &entry);
     void update();
     void updateTitle();
     void updateStatusBar();
@@ -40,9 +80,25 @@ private:
     void last();
     void updateMoveButtons();
 
+    void filter(const QString &text);
+
+    void showText(const QString &text);
+    void updateFilterText();
+    void updateViewport();
+    void updateMaxDecodeSize();
+    void watchScreen(QScreen *screen);
+
+    void toggleSlideshow(bool checked);
+    void prepareSlide();
+    void showSlide();
+    void buildNameIndex(QSharedPointer<Session> target);
+    void findDuplicates(std::function<void()> onReady);
+    void nextDuplicate();
+
     void sortBySize();
     void sortByMtime();
     void sortByBtime();
+    void sortBySimilarity();
     void setOrderDirectionInButtons();
 
     void wheelEvent(QWheelEvent *event) override;
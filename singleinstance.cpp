@@ -0,0 +1,92 @@
+#include "singleinstance.h"
+#include <QLocalSocket>
+#include <QFileInfo>
+#include <QDir>
+
+
+SingleInstance::SingleInstance(QObject *parent) : QObject(parent) {
+    QString user = qEnvironmentVariable("USERNAME", qEnvironmentVariable("USER"));
+    serverName = "demo-imgv-" + user;
+    connect(&server, &QLocalServer::newConnection, this, &SingleInstance::onNewConnection);
+}
+
+/**
+ * Sends `path` to the running instance. An empty `path` just activates it.
+ *
+ * Returns `false` if there is no running instance (or it does not respond),
+ * so, this process should handle the path by itself.
+ */
+bool SingleInstance::forward(QString path) {
+    if (!path.isEmpty() && QFileInfo(path).isRelative()) { // The running instance has another working directory
+        path = QDir::current().absoluteFilePath(path);
+    }
+
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected(timeout)) {
+        return false;
+    }
+    socket.write(path.toUtf8() + terminator);
+    if (!socket.waitForBytesWritten(timeout)) {
+        return false;
+    }
+    socket.disconnectFromServer();
+    if (socket.state() != QLocalSocket::UnconnectedState) {
+        socket.waitForDisconnected(timeout);
+    }
+    qDebug().noquote() << "[SingleInstance][forwarded]:" << path;
+    return true;
+}
+
+/**
+ * Makes this process the running instance.
+ */
+bool SingleInstance::listen() {
+    server.setSocketOptions(QLocalServer::UserAccessOption); // Other users must not make it to open their paths
+    if (server.listen(serverName)) {
+        return true;
+    }
+    // A socket file can be left after a crash (on Unix), remove it and try again,
+    // but only if there is no live server, else the running instance would become unreachable.
+    if (server.serverError() == QAbstractSocket::AddressInUseError) {
+        if (isServerAlive()) {
+            qDebug().noquote() << "[SingleInstance][listen]: the running instance is alive";
+            return false;
+        }
+        QLocalServer::removeServer(serverName);
+        return server.listen(serverName);
+    }
+    qDebug().noquote() << "[SingleInstance][listen]:" << server.errorString();
+    return false;
+}
+
+bool SingleInstance::isServerAlive() {
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected(timeout)) {
+        return false;
+    }
+    socket.abort();
+    return true;
+}
+
+void SingleInstance::onNewConnection() {
+    QLocalSocket *socket = server.nextPendingConnection();
+    // The client sends the path (or nothing, to activate the window) with the terminator and disconnects.
+    // A connection without the terminator (e.g. the liveness probe of `listen`) is ignored.
+    connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+        QByteArray message = socket->readAll();
+        socket->deleteLater();
+        if (!message.endsWith(terminator)) {
+            return;
+        }
+        QString path = QString::fromUtf8(message.chopped(1));
+        if (path.isEmpty()) {
+            qDebug().noquote() << "[SingleInstance][activation]";
+            emit activationRequested();
+        } else {
+            qDebug().noquote() << "[SingleInstance][received]:" << path;
+            emit pathReceived(path);
+        }
+    });
+}
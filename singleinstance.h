@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QObject>
+#include <QLocalServer>
+
+
+/**
+ * Keeps the only one running instance of the program.
+ *
+ * A second launch forwards its input path to the running instance through a local socket and exits.
+ * A launch without a path asks the running instance to activate its window.
+ * `--new-instance` opens a separate window, without the single instance mode.
+ * So, the opened file is handled by the warm process: no Qt startup, no image format plugins loading,
+ * and no directory parsing, if the file is from the already opened directory.
+ */
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    SingleInstance(QObject *parent = nullptr);
+
+    static inline const QString newInstanceOption = "--new-instance";
+
+    bool forward(QString path);
+    bool listen();
+
+signals:
+    void pathReceived(QString path);
+    void activationRequested();
+
+private:
+    static const int timeout = 1000; // ms
+    static const char terminator = '\n'; // ends a message, a connection closed without it is ignored
+    QString serverName;
+    QLocalServer server;
+
+    bool isServerAlive();
+    void onNewConnection();
+};
@@ -0,0 +1,66 @@
+#include "slideshow.h"
+#include <QDebug>
+
+
+Slideshow::Slideshow(QObject *parent) : QObject(parent) {
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &Slideshow::deadlineReached);
+}
+
+void Slideshow::start(int interval) {
+    this->interval = interval;
+    active        = true;
+    frames        = 0;
+    missed        = 0;
+    latenessTotal = 0;
+    latenessMax   = 0;
+
+    clock.start();
+    deadline = interval;
+    schedule();
+}
+
+void Slideshow::stop() {
+    if (!active) {
+        return;
+    }
+    active = false;
+    timer.stop();
+    qDebug().noquote() << "[slideshow][stop]:" << frames << "frames," << missed << "missed,"
+                       << "lateness avg" << (frames ? latenessTotal / frames : 0) << "ms,"
+                       << "max" << latenessMax << "ms";
+}
+
+void Slideshow::setInterval(int interval) {
+    this->interval = interval; // Applies from the next deadline
+}
+
+bool Slideshow::isActive() {
+    return active;
+}
+
+void Slideshow::schedule() {
+    timer.start(qMax<qint64>(0, deadline - clock.elapsed()));
+}
+
+void Slideshow::frameShown() {
+    if (!active) {
+        return;
+    }
+    const qint64 now = clock.elapsed();
+    const qint64 lateness = qMax<qint64>(0, now - deadline);
+    frames++;
+    latenessTotal += lateness;
+    latenessMax = qMax(latenessMax, lateness);
+    if (lateness > tolerance) {
+        missed++;
+        qDebug().noquote() << "[slideshow][missed]: frame" << frames << "is late by" << lateness << "ms";
+    }
+
+    deadline += interval;
+    if (deadline <= now) { // The next deadline is missed too — start the grid anew, instead of showing the frames in a burst
+        deadline = now + interval;
+    }
+    schedule();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+
+/**
+ * Deadline scheduling for the slideshow.
+ *
+ * The deadlines are on a fixed grid (`start + n * interval`), so a late frame does not shift the next ones.
+ * Emits `deadlineReached` on time, the receiver shows the (prepared in advance) image and calls `frameShown`,
+ * which measures the lateness and schedules the next deadline.
+ */
+class Slideshow : public QObject
+{
+    Q_OBJECT
+
+public:
+    Slideshow(QObject *parent = nullptr);
+
+    void start(int interval);
+    void stop();
+    void setInterval(int interval);
+    bool isActive();
+
+    void frameShown();
+
+signals:
+    void deadlineReached();
+
+private:
+    static const int tolerance = 16; // ms, one frame of a 60 Hz display
+
+    QTimer timer;
+    QElapsedTimer clock;
+    int interval = 0;
+    qint64 deadline = 0; // ms, by `clock`
+    bool active = false;
+
+    // Telemetry
+    int    frames        = 0;
+    int    missed        = 0;
+    qint64 latenessTotal = 0;
+    qint64 latenessMax   = 0;
+
+    void schedule();
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QPixmap>
+#include <QSize>
+
+
+/**
+ * The image scaled to fit a viewport (but never upscaled), to be painted 1:1 by `ImageCanvas`.
+ *
+ * It has no widget dependency, so the surface can be prepared in advance (in a background thread)
+ * by `Cache` and the slideshow.
+ */
+class Surface {
+public:
+    // Both sizes are in the device pixels.
+    static QSize fitSize(QSize imageSize, QSize viewport) {
+        if (imageSize.width() > viewport.width() || imageSize.height() > viewport.height()) {
+            imageSize.scale(viewport, Qt::KeepAspectRatio);
+        }
+        return imageSize;
+    }
+
+    // `viewport` is in the logical pixels, the fitting is done in the device ones.
+    static QPixmap scaleToFit(const QPixmap &image, QSize viewport, qreal dpr) {
+        if (image.isNull()) {
+            return QPixmap();
+        }
+        const QSize size = fitSize(image.size(), viewport * dpr);
+        QPixmap surface;
+        if (size == image.size()) {
+            surface = image;
+        } else {
+            surface = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+        surface.setDevicePixelRatio(dpr);
+        return surface;
+    }
+
+    // `surface` is `image` prepared with `scaleToFit` for the same viewport and DPR
+    static bool isFitted(const QPixmap &surface, const QPixmap &image, QSize viewport, qreal dpr) {
+        return !surface.isNull()
+                && surface.devicePixelRatio() == dpr
+                && surface.size() == fitSize(image.size(), viewport * dpr);
+    }
+};
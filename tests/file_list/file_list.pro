@@ -0,0 +1,14 @@
+# The navigation of DirectoryFileList with a filter.
+# Build and run: qmake && make && ./file_list (or `make check` from the root).
+
+QT     += core gui concurrent
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+TARGET  = file_list
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,85 @@
+#include <QGuiApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include "core.h"
+
+
+static int failures = 0;
+
+static void check(bool condition, const char *description) {
+    if (!condition) {
+        failures++;
+    }
+    qDebug().noquote() << (condition ? "[ OK ]" : "[FAIL]") << description;
+}
+
+static void createFile(const QString &path, int minutes) {
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.setFileTime(QDateTime(QDate(2024, 1, 1), QTime(0, minutes)), QFileDevice::FileModificationTime);
+}
+
+static void buildNameIndex(DirectoryFileList &fileList) {
+    FileNameIndex index = fileList.getNameIndex();
+    index.sync(fileList.getNames());
+    fileList.setNameIndex(index);
+}
+
+// The selected entry is always in the filtered view, and the title index is in the view range
+static void checkSelection(DirectoryFileList &fileList, const char *description) {
+    const int index = fileList.getSelectedFileEntryIndex();
+    check(index >= 1 && index <= fileList.getViewCount(), description);
+}
+
+int main(int argc, char *argv[])
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication application(argc, argv);
+
+    // By mtime: a1, a2, b1, zzz (sorts after every filtered entry)
+    QTemporaryDir dir;
+    createFile(dir.path() + "/a1.png",  1);
+    createFile(dir.path() + "/a2.png",  2);
+    createFile(dir.path() + "/b1.png",  3);
+    createFile(dir.path() + "/zzz.png", 4);
+
+    DirectoryFileList fileList;
+    fileList.initImage(dir.path());
+    fileList.initFileList();
+    fileList.sort();
+    buildNameIndex(fileList);
+
+    fileList.filter("a");
+    check(fileList.getViewCount() == 2, "the filter passes 2 entries");
+
+    // Open a file of the same directory, that does not pass the filter
+    fileList.initImage(dir.path() + "/zzz.png");
+    check(fileList.getSelectedFileEntry().name == "zzz.png", "the opened file is selected");
+    check(!fileList.isFiltered(), "the filter is removed for the opened file");
+    checkSelection(fileList, "the opened file is in the view");
+    check(!fileList.goNext(), "next: it's the last one");
+    check(fileList.goBack() && fileList.getSelectedFileEntry().name == "b1.png", "back: b1");
+
+    // A new file, it's not in the list yet: the directory is rescanned
+    fileList.filter("a");
+    createFile(dir.path() + "/zzz2.png", 5);
+    DirState state = fileList.initImage(dir.path() + "/zzz2.png");
+    check(state == DS::Preview, "the new file is a preview");
+    fileList.goNext(); // Must not crash in the preview state
+    fileList.initFileList();
+    fileList.sort();
+    check(fileList.getSelectedFileEntry().name == "zzz2.png", "the new file is selected");
+    check(!fileList.isFiltered(), "the filter is removed for the new file");
+    checkSelection(fileList, "the new file is in the view");
+    check(!fileList.goNext(), "next: it's the last one");
+
+    // The navigation is in the view
+    fileList.filter("a");
+    checkSelection(fileList, "the selection is snapped into the view by the filter");
+    fileList.goFirst();
+    check(fileList.goNext() && fileList.getSelectedFileEntry().name == "a2.png", "next in the view: a2");
+    check(!fileList.goNext(), "next in the view: a2 is the last one");
+
+    qDebug().noquote() << "[file_list]:" << (failures ? "FAIL" : "OK");
+    return failures ? 1 : 0;
+}
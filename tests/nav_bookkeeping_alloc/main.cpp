@@ -0,0 +1,136 @@
+#include <QGuiApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QPixmap>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "core.h"
+
+
+/**
+ * Counts the allocations with the replaced global `operator new`.
+ * Qt containers allocate with `malloc`, so it's counted too (with glibc, where it can be replaced).
+ */
+static std::atomic<bool>   counting {false};
+static std::atomic<qint64> allocations {0};
+
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+extern "C" void *malloc(size_t size) {
+    if (counting) {
+        allocations++;
+    }
+    return __libc_malloc(size);
+}
+extern "C" void *calloc(size_t count, size_t size) {
+    if (counting) {
+        allocations++;
+    }
+    return __libc_calloc(count, size);
+}
+extern "C" void *realloc(void *pointer, size_t size) {
+    if (counting) {
+        allocations++;
+    }
+    return __libc_realloc(pointer, size);
+}
+static void *allocate(size_t size) {
+    return __libc_malloc(size);
+}
+#else
+static void *allocate(size_t size) {
+    return std::malloc(size);
+}
+#endif
+
+static void *countedNew(size_t size) {
+    if (counting) {
+        allocations++;
+    }
+    if (void *pointer = allocate(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+void *operator new(size_t size)   { return countedNew(size); }
+void *operator new[](size_t size) { return countedNew(size); }
+void operator delete(void *pointer) noexcept           { std::free(pointer); }
+void operator delete[](void *pointer) noexcept         { std::free(pointer); }
+void operator delete(void *pointer, size_t) noexcept   { std::free(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { std::free(pointer); }
+
+
+int main(int argc, char *argv[])
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication application(argc, argv);
+
+    QFile baselineFile(BASELINE_PATH);
+    if (!baselineFile.open(QIODevice::ReadOnly)) {
+        qDebug().noquote() << "[nav_bookkeeping_alloc]: No baseline:" << BASELINE_PATH;
+        return 2;
+    }
+    const qint64 baseline = baselineFile.readAll().trimmed().toLongLong();
+
+    // The files are not decoded, the images are put in the cache directly
+    const int fileCount = 64;
+    QTemporaryDir dir;
+    for (int i = 0; i < fileCount; i++) {
+        QFile file(dir.path() + "/" + QString::number(i).rightJustified(5, '0') + ".png");
+        file.open(QIODevice::WriteOnly);
+    }
+    DirectoryFileList fileList;
+    fileList.initImage(dir.path());
+    fileList.initFileList();
+    fileList.sort();
+
+    QPixmap pixmap(4, 4);
+    pixmap.fill(Qt::gray);
+    const DecodedImage image {pixmap, pixmap.size(), pixmap};
+
+    Cache cache;
+    QList<QString> names;
+    QList<QString> ahead;
+    const int warmUpSteps = 2; // the reused lists get their capacity
+    qint64 maxCount = 0;
+    qint64 total = 0;
+    int steps = 0;
+    for (;;) {
+        // The preloading of the previous step is done: the entries of the next window are cached
+        fileList.namesRange(1, 2, ahead);
+        for (const QString &name : ahead) {
+            if (!cache.has(name)) {
+                cache.set(name, image);
+            }
+        }
+
+        allocations = 0;
+        counting = true;
+        const bool moved = fileList.goNext();
+        fileList.namesRange(1, 1, names);
+        cache.cacheOnly(names, fileList.getDirPath());
+        counting = false;
+
+        if (!moved) {
+            break;
+        }
+        if (++steps > warmUpSteps) {
+            maxCount = qMax<qint64>(maxCount, allocations);
+            total += allocations;
+        }
+    }
+
+    qDebug().noquote() << "[nav_bookkeeping_alloc]: steps:" << steps - warmUpSteps
+                       << "allocations: total" << total << "max per step" << maxCount
+                       << "baseline" << baseline;
+    if (maxCount > baseline) {
+        qDebug().noquote() << "[nav_bookkeeping_alloc]: FAIL, the allocation count per step regressed";
+        return 1;
+    }
+    qDebug().noquote() << "[nav_bookkeeping_alloc]: OK";
+    return 0;
+}
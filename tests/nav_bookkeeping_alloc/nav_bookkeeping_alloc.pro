@@ -0,0 +1,18 @@
+# Counts the heap allocations of the bookkeeping of a navigation step over a pre-cached file list:
+# `DirectoryFileList::goNext`, `namesRange` and `Cache::cacheOnly`.
+# The widget part of `MainWindow::next` (the title, the status bar, the canvas) is not covered.
+# Build and run: qmake && make && ./nav_bookkeeping_alloc (or `make check` from the root).
+# It fails, if the max allocation count per step exceeds the number in `baseline.txt`.
+
+QT     += core gui concurrent
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+TARGET  = nav_bookkeeping_alloc
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000
+DEFINES += BASELINE_PATH=\\\"$$PWD/baseline.txt\\\"
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,7 @@
+# `make check` from the root builds and runs them, each test returns non-zero on a failure.
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    file_list \
+    nav_bookkeeping_alloc
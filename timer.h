@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QString>
+#include <QMap>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QDebug>
+
+class Timer {
+    inline static QMutex mutex; // the timers are used in the thread pool too
+    inline static QMap<QString, QElapsedTimer> map;
+public:
+    static void start(QString name) {
+        QElapsedTimer timer;
+        timer.start();
+        QMutexLocker locker(&mutex);
+        map.insert(name, timer);
+    }
+    static int elapsed(QString name) {
+        QMutexLocker locker(&mutex);
+        if (!map.contains(name)) {
+            qDebug().noquote() << "[timer][" + name + "]: Not found.";
+        }
+        int time = map.take(name).elapsed();
+        qDebug().noquote() << "[timer][" + name + "]:" << time << "ms";
+        return time;
+    }
+};